@@ -8,7 +8,10 @@
  * 
  * Usage:
  *   #include "arena.h"
- *   // Link with arena.c when compiling
+ *   // Link with arena.c when compiling, or, as a single header, in
+ *   // exactly one source file and before any other #include:
+ *   #define ARENA_IMPLEMENTATION
+ *   #include "arena.h"
  * 
  * Example:
  *   Arena arena = arena_init(1024);
@@ -20,12 +23,17 @@
 #ifndef ARENA_H
 #define ARENA_H
 
+#if defined(ARENA_IMPLEMENTATION) && !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <stdarg.h>
 
 #ifndef ARENA_INIT_SIZE
 #define ARENA_INIT_SIZE 128
@@ -35,16 +43,403 @@
 #define ARENA_ALIGNMENT 8
 #endif
 
+#ifndef ARENA_GROWTH_FACTOR
+#define ARENA_GROWTH_FACTOR 2.0
+#endif
+
+#ifndef ARENA_MAX_BLOCK_SIZE
+#define ARENA_MAX_BLOCK_SIZE ((size_t)64 * 1024 * 1024)
+#endif
+
+#ifndef ARENA_COMMIT_SIZE
+#define ARENA_COMMIT_SIZE ((size_t)64 * 1024)
+#endif
+
+#define ARENA_SIZE_CLASSES 64
+
+#ifndef ARENA_POOL_BLOCK_SIZE
+#define ARENA_POOL_BLOCK_SIZE ((size_t)64 * 1024)
+#endif
+
+// ARENA_DEBUG (defined for every file, arena.c included) surrounds each
+// allocation with a redzone, fills fresh and released memory with
+// patterns, and under AddressSanitizer poisons everything not handed out
+#ifdef ARENA_DEBUG
+#ifndef ARENA_DEBUG_REDZONE
+#define ARENA_DEBUG_REDZONE 16
+#endif
+#else
+#undef ARENA_DEBUG_REDZONE
+#define ARENA_DEBUG_REDZONE 0
+#endif
+
+#ifndef ARENA_DEBUG_ALLOC_BYTE
+#define ARENA_DEBUG_ALLOC_BYTE 0xCD
+#endif
+
+#ifndef ARENA_DEBUG_FREE_BYTE
+#define ARENA_DEBUG_FREE_BYTE 0xDD
+#endif
+
+#ifndef ARENA_NUMA_MAX_NODES
+#define ARENA_NUMA_MAX_NODES 64
+#endif
+
+/** NUMA node meaning "whichever node first touches the memory" */
+#define ARENA_NUMA_LOCAL (-1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Page size to back arena blocks with.
+ */
+typedef enum ArenaHugePages {
+    ARENA_HUGE_PAGES_NONE = 0,   /**< Normal pages from the arena's allocator */
+    ARENA_HUGE_PAGES_2MB,        /**< 2 MB huge pages */
+    ARENA_HUGE_PAGES_1GB,        /**< 1 GB huge pages */
+} ArenaHugePages;
+
+/**
+ * Backing allocator blocks are obtained from and returned to.
+ * alloc returns NULL on failure; free receives the size that was
+ * allocated. alloc_zeroed, if set, is used for blocks that arena_calloc
+ * wants zero-filled, so fresh pages need no clearing. Leaving alloc NULL
+ * in an ArenaConfig selects the default, which uses ARENA_ALLOC and
+ * ARENA_FREE (and calloc, unless ARENA_ALLOC is overridden).
+ */
+typedef struct ArenaAllocator {
+    void *(*alloc)(void *context, size_t size);            /**< Allocate size bytes */
+    void (*free)(void *context, void *ptr, size_t size);   /**< Free an allocation of size bytes */
+    void *context;                                         /**< Passed to every hook */
+    void *(*alloc_zeroed)(void *context, size_t size);     /**< Optional: allocate zero-filled bytes, freed with free */
+} ArenaAllocator;
+
+/**
+ * What arena_reset does with the blocks of a chained arena.
+ */
+typedef enum ArenaResetPolicy {
+    ARENA_RESET_KEEP = 0,        /**< Keep every block for reuse */
+    ARENA_RESET_COALESCE,        /**< Replace the chain with one block sized to the cycle's high-water mark */
+    ARENA_RESET_TRIM,            /**< Keep blocks up to retain_size of capacity, free the rest */
+} ArenaResetPolicy;
+
+/**
+ * What an arena does when it cannot get memory for an allocation, either
+ * from its allocator or because its reservation is exhausted. Only the
+ * slow path consults it; bump allocation never does.
+ */
+typedef enum ArenaFailurePolicy {
+    ARENA_FAIL_ABORT = 0,        /**< Report on stderr with write() and abort() */
+    ARENA_FAIL_NULL,             /**< Return NULL from the allocation */
+    ARENA_FAIL_CALLBACK,         /**< Call on_failure; retry once if it returns true, NULL otherwise */
+    ARENA_FAIL_EMERGENCY,        /**< Serve from a block set aside at init from allocator (never the pool), then return NULL */
+} ArenaFailurePolicy;
+
+struct Arena;
+
+/**
+ * Called by ARENA_FAIL_CALLBACK arenas when an allocation fails. The
+ * handler may reset the arena or free memory elsewhere.
+ * @param arena Arena the allocation failed in
+ * @param size Number of bytes that were requested
+ * @param context failure_context from the arena's config
+ * @return true to retry the allocation once, false to return NULL
+ */
+typedef bool (*ArenaFailureHandler)(struct Arena *arena, size_t size, void *context);
+
+/**
+ * A single memory block. Blocks are chained into a linked list.
+ * Heap blocks are one allocation with the data right after the header;
+ * virtual and huge page blocks keep the header apart so their data stays
+ * page aligned.
+ */
+typedef struct ArenaBlock {
+    struct ArenaBlock *next; /**< Next block in the chain */
+    size_t capacity;         /**< Total capacity of this block (committed bytes if virtual) */
+    size_t size;             /**< Currently used bytes in this block */
+    uint8_t *data;           /**< Pointer to the memory block, just past the header for heap blocks */
+    size_t reserved;         /**< Mapped address space of a virtual or huge page block, 0 otherwise */
+    size_t dirty;            /**< Highest size the block had before shrinking; past max(dirty, size) the data is zero */
+} ArenaBlock;
+
+/**
+ * Shared pool of recycled blocks, safe to use from any thread.
+ * Arenas bound to a pool take their blocks from it before allocating new
+ * ones, and give them back on arena_reset and arena_free.
+ */
+typedef struct ArenaBlockPool {
+    ArenaBlock *free;        /**< Lock-free stack of recycled blocks */
+    size_t block_size;       /**< Capacity of every pooled block */
+    bool pop_lock;           /**< Serializes pops; pushes never wait */
+    ArenaAllocator allocator; /**< Allocator pooled blocks come from */
+} ArenaBlockPool;
+
+/**
+ * Kind of operation an ArenaTraceEvent records.
+ */
+typedef enum ArenaTraceOp {
+    ARENA_TRACE_ALLOC = 0,       /**< arena_alloc and friends */
+    ARENA_TRACE_REALLOC,         /**< arena_realloc */
+    ARENA_TRACE_RESET,           /**< arena_reset */
+} ArenaTraceOp;
+
+/**
+ * One traced operation, 32 bytes. Trace files store these as is, so they
+ * are only portable between machines with the same byte order.
+ */
+typedef struct ArenaTraceEvent {
+    uint64_t timestamp;      /**< Nanoseconds since the trace was created */
+    uint64_t size;           /**< Requested size (new size for a realloc) */
+    uint64_t old_size;       /**< Previous size for a realloc, 0 otherwise */
+    uint32_t block;          /**< Index in the chain of the block that served it */
+    uint8_t op;              /**< ArenaTraceOp */
+    uint8_t align_log2;      /**< log2 of the requested alignment */
+    uint16_t unused;         /**< Padding, always 0 */
+} ArenaTraceEvent;
+
+/**
+ * Ring buffer of trace events. Once full, new events overwrite the oldest.
+ * Recording is compiled in only when ARENA_TRACE is defined (for every
+ * file, arena.c included); an arena records while its trace is non-NULL.
+ */
+typedef struct ArenaTrace {
+    ArenaTraceEvent *events; /**< Ring storage */
+    size_t capacity;         /**< Number of events held, a power of 2 */
+    uint64_t head;           /**< Events recorded so far; the next goes at head % capacity */
+    uint64_t start;          /**< Clock reading timestamps are relative to */
+    const ArenaBlock *last_block; /**< Block of the previous event, to avoid walking the chain */
+    uint32_t last_index;     /**< Chain index of last_block */
+} ArenaTrace;
+
+/**
+ * Allocation statistics. The counters are kept up to date by every
+ * allocation at O(1) cost; arena_stats adds the fields marked snapshot.
+ * arena_concurrent_alloc only maintains blocks_created.
+ */
+typedef struct ArenaStats {
+    size_t allocations;      /**< Successful allocations (a batch counts once) */
+    size_t bytes_requested;  /**< Bytes asked for, resized along with in-place reallocations */
+    size_t bytes_allocated;  /**< Bytes taken from blocks, including alignment padding */
+    size_t wasted_bytes;     /**< Unused tails of blocks the arena moved past */
+    size_t blocks_created;   /**< Blocks acquired from the allocator or a pool */
+    size_t realloc_copies;   /**< Reallocations that had to move */
+    size_t bytes_copied;     /**< Bytes copied by moving reallocations */
+    size_t peak_used;        /**< Highest usage reached (snapshot folds in the current cycle) */
+    size_t capacity;         /**< Snapshot: total capacity of the block chain */
+    size_t used;             /**< Snapshot: bytes currently in use */
+    size_t block_count;      /**< Snapshot: blocks in the chain */
+} ArenaStats;
+
+/**
+ * Header at the start of an arena image file. Allocations follow it, so
+ * no allocation lives at offset 0 and an ArenaOffset of 0 means NULL.
+ * Like trace files, images are only portable between machines with the
+ * same byte order.
+ */
+typedef struct ArenaFileHeader {
+    char magic[8];           /**< "ARENAIMG" */
+    uint32_t version;        /**< Format version, 1 */
+    uint32_t header_size;    /**< sizeof(ArenaFileHeader) */
+    uint64_t capacity;       /**< Bytes available to allocations */
+    uint64_t used;           /**< Bytes in use at the last arena_save */
+    uint64_t root;           /**< Offset of the root object, 0 for none */
+    uint64_t generation;     /**< Bumped by every arena_reset, see arena_shared_enter */
+    uint64_t readers;        /**< Readers between arena_shared_enter and arena_shared_leave */
+    uint64_t unused;         /**< Padding to 64 bytes, always 0 */
+} ArenaFileHeader;
+
+/**
+ * Position-independent reference into a file-backed arena: the distance
+ * from the start of the file, or 0 for NULL. Unlike a raw pointer it stays
+ * valid wherever the file gets mapped, so structures stored in the file
+ * link their nodes with offsets.
+ */
+typedef uint64_t ArenaOffset;
+
 /**
  * Arena structure representing a memory pool.
- * Arenas are organized as a linked list of memory blocks.
+ * Arenas are organized as a linked list of memory blocks. The arena keeps
+ * a cursor to the block currently being bumped so allocation never has to
+ * walk the chain.
  */
 typedef struct Arena {
-    struct Arena *next;     /**< Next arena block in the chain */
-    size_t capacity;        /**< Total capacity of this block */
-    size_t size;           /**< Currently used bytes in this block */
-    uint8_t *data;         /**< Pointer to the memory block */
+    ArenaBlock *first;       /**< First block in the chain */
+    ArenaBlock *current;     /**< Active block allocations are served from */
+    size_t block_size;       /**< Capacity of the last block sized by the growth policy */
+    size_t min_block_size;   /**< Smallest block the growth policy creates */
+    size_t max_block_size;   /**< Largest block the growth policy creates */
+    double growth_factor;    /**< Each new block is this multiple of the previous one */
+    ArenaBlockPool *pool;    /**< Pool blocks are recycled through, or NULL */
+    size_t retain_size;      /**< Memory kept across arena_reset */
+    size_t reserve_size;     /**< Address space of a virtual arena, 0 for chained blocks */
+    ArenaHugePages huge_pages; /**< Page size blocks are mapped with */
+    ArenaResetPolicy reset_policy; /**< What arena_reset does with the blocks */
+    size_t used_before;      /**< Used bytes of the blocks before the cursor */
+    size_t high_water;       /**< Peak usage since the last arena_reset */
+    void **free_lists;       /**< Released chunks per power-of-two size class, or NULL */
+    uint64_t free_mask;      /**< Bit k set when free_lists[k] is non-empty */
+    ArenaAllocator allocator; /**< Allocator blocks come from */
+    ArenaStats stats;        /**< Running counters, see arena_stats */
+    ArenaTrace *trace;       /**< Trace being recorded into, or NULL */
+    ArenaFileHeader *file;   /**< Mapped image of a file-backed arena, or NULL */
+    bool read_only;          /**< File-backed arena mapped without write access */
+    ArenaFailurePolicy failure_policy; /**< What a failed allocation does */
+    ArenaFailureHandler on_failure; /**< Handler of ARENA_FAIL_CALLBACK arenas */
+    void *failure_context;   /**< Passed to on_failure */
+    size_t emergency_size;   /**< Capacity of the emergency block */
+    ArenaBlock *emergency;   /**< Emergency block of ARENA_FAIL_EMERGENCY arenas, or NULL */
+    bool emergency_used;     /**< The emergency block is in the chain until the next arena_reset */
 } Arena;
+
+/**
+ * Checkpoint of an arena's allocation position, taken by arena_mark.
+ */
+typedef struct ArenaMark {
+    ArenaBlock *block;       /**< Block that was current when the mark was taken */
+    size_t size;             /**< Used bytes of that block at the time */
+    size_t used_before;      /**< Used bytes of the blocks before it */
+} ArenaMark;
+
+/**
+ * Arena that many threads can allocate from at once.
+ * Allocation is an atomic fetch-add on the active block's offset; when a
+ * block runs out the next one is chained with a compare-and-swap on its
+ * next pointer, so allocating threads never take a lock. The embedded
+ * arena can be inspected with arena_print and friends once the threads
+ * are done with it.
+ */
+typedef struct ArenaConcurrent {
+    Arena arena;             /**< Block chain shared by all threads */
+} ArenaConcurrent;
+
+/**
+ * Pair of arenas for allocations that live until the end of the next tick
+ * of a loop. Each arena_frame_tick swaps the two and resets the one that
+ * becomes current, which keeps its blocks: after the first few ticks both
+ * sides allocate from memory that is already mapped and warm.
+ */
+typedef struct ArenaFrame {
+    Arena arenas[2];         /**< The current and the previous tick's arena, alternately */
+    unsigned current;        /**< Index of the arena this tick allocates from */
+    uint64_t tick;           /**< Number of arena_frame_tick calls */
+} ArenaFrame;
+
+/**
+ * One block pool per NUMA node, for thread pools spread across sockets.
+ * Each pool's blocks are placed on its node, so a thread that draws its
+ * arena from the pool of the node it runs on only touches local memory.
+ */
+typedef struct ArenaNumaSet {
+    ArenaBlockPool *pools;   /**< One pool per node, indexed by node number */
+    int node_count;          /**< Number of nodes */
+} ArenaNumaSet;
+
+/**
+ * Pool of fixed-size slots carved out of an arena.
+ * Freed slots go on an intrusive free-list and are handed out again
+ * before new ones are carved; all of them are released in bulk with the
+ * backing arena.
+ */
+typedef struct ArenaPool {
+    Arena *arena;            /**< Arena slots are carved from */
+    size_t slot_size;        /**< Size of every slot */
+    void *free_list;         /**< Freed slots, linked through their first word */
+} ArenaPool;
+
+/**
+ * Create a pool for objects of a given type.
+ */
+#define ARENA_POOL(arena, type) arena_pool_init((arena), sizeof(type))
+
+/**
+ * Growable array of fixed-size items stored in an arena.
+ * While the array is the arena's most recent allocation it grows in
+ * place; otherwise it moves and the old buffer is released to the arena.
+ */
+typedef struct ArenaArray {
+    Arena *arena;            /**< Arena items are stored in */
+    void *data;              /**< Items, or NULL while empty */
+    size_t length;           /**< Number of items */
+    size_t capacity;         /**< Number of items that fit without growing */
+    size_t item_size;        /**< Size of each item */
+} ArenaArray;
+
+/**
+ * Create an array of items of a given type.
+ */
+#define ARENA_ARRAY(arena, type) arena_array_init((arena), sizeof(type))
+
+/**
+ * Access an item of an array as a given type.
+ */
+#define ARENA_ARRAY_AT(array, type, index) (((type*)(array)->data)[index])
+
+/**
+ * Entry of an ArenaMap. An entry with hash 0 is empty.
+ */
+typedef struct ArenaMapEntry {
+    const char *key;         /**< Copy of the key in the arena, NUL-terminated */
+    size_t key_length;       /**< Length of the key in bytes */
+    void *value;             /**< Value stored for the key */
+    uint64_t hash;           /**< Hash of the key, never 0 for a used entry */
+} ArenaMapEntry;
+
+/**
+ * Open-addressing hash map whose buckets and keys live in an arena.
+ * Collisions are resolved with Robin Hood linear probing, which keeps
+ * probe sequences short and lets lookups of missing keys stop early.
+ * There is nothing to tear down: the map goes away with its arena.
+ */
+typedef struct ArenaMap {
+    Arena *arena;            /**< Arena buckets and keys are stored in */
+    ArenaMapEntry *entries;  /**< Buckets, or NULL until the first insert */
+    size_t count;            /**< Number of used entries */
+    size_t capacity;         /**< Number of buckets, a power of two */
+} ArenaMap;
+
+/**
+ * Table storing each distinct string once in an arena.
+ * Interned strings never move, so two strings are equal exactly when
+ * their interned pointers are.
+ */
+typedef struct ArenaIntern {
+    ArenaMap map;            /**< Interned strings, keyed by their bytes */
+} ArenaIntern;
+
+/**
+ * Growable, always NUL-terminated string stored in an arena.
+ */
+typedef struct ArenaString {
+    Arena *arena;            /**< Arena the characters are stored in */
+    char *data;              /**< Characters, or NULL while empty */
+    size_t length;           /**< Length excluding the terminator */
+    size_t capacity;         /**< Bytes available including the terminator */
+} ArenaString;
+
+/**
+ * Options for arena_init_config. Zero-valued fields take their defaults,
+ * so a designated initializer only needs to name what it changes.
+ */
+typedef struct ArenaConfig {
+    size_t capacity;         /**< Capacity of the first block (default ARENA_INIT_SIZE) */
+    size_t min_block_size;   /**< Smallest chained block (default ARENA_INIT_SIZE) */
+    size_t max_block_size;   /**< Growth cap for chained blocks (default ARENA_MAX_BLOCK_SIZE) */
+    double growth_factor;    /**< Growth per chained block, >= 1.0 (default ARENA_GROWTH_FACTOR) */
+    ArenaBlockPool *pool;    /**< Recycle pool-sized blocks through this pool (default none) */
+    size_t reserve_size;     /**< Reserve this much address space as one virtual block (default 0, heap blocks) */
+    size_t retain_size;      /**< Memory kept across reset by virtual and trimming arenas (default ARENA_COMMIT_SIZE) */
+    ArenaHugePages huge_pages; /**< Back blocks with huge pages (default ARENA_HUGE_PAGES_NONE) */
+    ArenaResetPolicy reset_policy; /**< What arena_reset does with the blocks (default ARENA_RESET_KEEP) */
+    bool free_lists;         /**< Reuse released chunks in arena_alloc (default false; dropped if their table can't be allocated under a non-abort policy) */
+    ArenaAllocator allocator; /**< Backing allocator for blocks (default ARENA_ALLOC/ARENA_FREE) */
+    ArenaTrace *trace;       /**< Record operations into this trace (default none; needs ARENA_TRACE) */
+    ArenaFailurePolicy failure_policy; /**< What a failed allocation does (default ARENA_FAIL_ABORT) */
+    ArenaFailureHandler on_failure; /**< Handler for ARENA_FAIL_CALLBACK */
+    void *failure_context;   /**< Passed to on_failure */
+    size_t emergency_size;   /**< Emergency block for ARENA_FAIL_EMERGENCY (default ARENA_POOL_BLOCK_SIZE) */
+} ArenaConfig;
 	
 
 /**
@@ -54,6 +449,145 @@ typedef struct Arena {
  */
 Arena arena_init(size_t capacity);
 
+/**
+ * Initialize a new arena with an explicit growth policy.
+ * Every chained block is growth_factor times the previous one, clamped to
+ * [min_block_size, max_block_size]. Requests larger than max_block_size
+ * get a dedicated block of exactly their size.
+ * @param config Arena options, or NULL for the defaults
+ * @return Initialized arena structure
+ */
+Arena arena_init_config(const ArenaConfig *config);
+
+/**
+ * Slow path of the allocators, taken when the current block is exhausted.
+ * Moves the cursor onto the next retained block that fits, or appends a
+ * new block to the end of the chain. Internal; use arena_alloc_aligned.
+ * @param arena Pointer to the arena
+ * @param size Number of bytes to allocate
+ * @param alignment Alignment boundary (must be power of 2)
+ * @return Pointer to allocated memory
+ */
+void *arena_alloc_slow(Arena *arena, size_t size, size_t alignment);
+
+/**
+ * Path of arena_alloc for arenas holding released chunks: reuses one from
+ * the free lists if it fits, or bumps. Internal; use arena_alloc.
+ * @param arena Pointer to the arena
+ * @param size Number of bytes to allocate
+ * @return Pointer to allocated memory
+ */
+void *arena_alloc_recycled(Arena *arena, size_t size);
+
+/**
+ * Allocation path of ARENA_DEBUG builds: bumps room for a redzone after
+ * the allocation, fills it with ARENA_DEBUG_ALLOC_BYTE and unpoisons only
+ * the requested bytes. Internal; use arena_alloc_aligned.
+ * @param arena Pointer to the arena
+ * @param size Number of bytes to allocate
+ * @param alignment Alignment boundary (must be power of 2)
+ * @return Pointer to allocated memory
+ */
+void *arena_alloc_debug(Arena *arena, size_t size, size_t alignment);
+
+/**
+ * Append an operation to the arena's trace. Internal; called by the
+ * allocation functions when built with ARENA_TRACE.
+ * @param arena Pointer to a traced arena
+ * @param op Operation
+ * @param size Requested size
+ * @param old_size Previous size of a realloc
+ * @param alignment Requested alignment
+ */
+void arena_trace_record(Arena *arena, ArenaTraceOp op, size_t size, size_t old_size, size_t alignment);
+
+#ifdef ARENA_TRACE
+#define ARENA_TRACE_EVENT(arena, op, size, old_size, alignment) \
+    do { \
+        if ((arena)->trace != NULL) { \
+            arena_trace_record((arena), (op), (size), (old_size), (alignment)); \
+        } \
+    } while (0)
+#else
+#define ARENA_TRACE_EVENT(arena, op, size, old_size, alignment) ((void)0)
+#endif
+
+/**
+ * Padding needed to align the next allocation in a block.
+ * @param block Pointer to the block
+ * @param alignment Alignment boundary (must be power of 2)
+ * @return Number of bytes to skip before the allocation
+ */
+static inline size_t arena_block_padding(const ArenaBlock *block, size_t alignment) {
+    return (size_t)(-(uintptr_t)&block->data[block->size]) & (alignment - 1);
+}
+
+/**
+ * Bump-allocate from a single block.
+ * @param block Pointer to the block
+ * @param size Number of bytes to allocate
+ * @param alignment Alignment boundary (must be power of 2)
+ * @return Pointer to allocated memory, or NULL if the block is too full
+ */
+static inline void *arena_block_bump(ArenaBlock *block, size_t size, size_t alignment) {
+    size_t padding = arena_block_padding(block, alignment);
+    size_t available = block->capacity - block->size;
+    if (padding > available || size > available - padding) {
+        return NULL;
+    }
+    
+    uint8_t *data = &block->data[block->size + padding];
+    block->size += padding + size;
+    return (void*)data;
+}
+
+/**
+ * Count an allocation in the arena's statistics.
+ * @param arena Pointer to the arena
+ * @param size Number of bytes requested
+ * @param consumed Number of block bytes it took, including padding
+ */
+static inline void arena_stats_count(Arena *arena, size_t size, size_t consumed) {
+    arena->stats.allocations++;
+    arena->stats.bytes_requested += size;
+    arena->stats.bytes_allocated += consumed;
+}
+
+/**
+ * Allocate memory from the arena at a given alignment.
+ * The returned pointer is aligned; the size is used as given, so only the
+ * padding in front of the allocation is spent on alignment.
+ * Inlined, so constant sizes and alignments fold at the call site.
+ * @param arena Pointer to the arena
+ * @param size Number of bytes to allocate
+ * @param alignment Alignment boundary (must be power of 2)
+ * @return Pointer to allocated memory, or NULL on failure
+ */
+static inline void *arena_alloc_aligned(Arena *arena, size_t size, size_t alignment) {
+    if (arena == NULL || size == 0) {
+        return NULL;
+    }
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+    
+#ifdef ARENA_DEBUG
+    void *data = arena_alloc_debug(arena, size, alignment);
+#else
+    ArenaBlock *current = arena->current;
+    if (current != NULL) {
+        size_t before = current->size;
+        void *data = arena_block_bump(current, size, alignment);
+        if (data != NULL) {
+            arena_stats_count(arena, size, current->size - before);
+            ARENA_TRACE_EVENT(arena, ARENA_TRACE_ALLOC, size, 0, alignment);
+            return data;
+        }
+    }
+    void *data = arena_alloc_slow(arena, size, alignment);
+#endif
+    ARENA_TRACE_EVENT(arena, ARENA_TRACE_ALLOC, size, 0, alignment);
+    return data;
+}
+
 /**
  * Allocate memory from the arena.
  * Memory is aligned to ARENA_ALIGNMENT bytes.
@@ -61,11 +595,90 @@ Arena arena_init(size_t capacity);
  * @param size Number of bytes to allocate
  * @return Pointer to allocated memory, or NULL on failure
  */
-void *arena_alloc(Arena *arena, size_t size);
+static inline void *arena_alloc(Arena *arena, size_t size) {
+    // free_mask stays zero unless the arena opted into free lists
+    if (arena != NULL && arena->free_mask != 0 && size != 0) {
+        return arena_alloc_recycled(arena, size);
+    }
+    return arena_alloc_aligned(arena, size, ARENA_ALIGNMENT);
+}
+
+/**
+ * Allocate unaligned memory from the arena, for byte buffers and strings.
+ * Consecutive packed allocations sit back to back with no padding.
+ * @param arena Pointer to the arena
+ * @param size Number of bytes to allocate
+ * @return Pointer to allocated memory, or NULL on failure
+ */
+static inline void *arena_alloc_packed(Arena *arena, size_t size) {
+    return arena_alloc_aligned(arena, size, 1);
+}
+
+/**
+ * Allocate zero-filled memory, aligned to ARENA_ALIGNMENT bytes.
+ * Each block remembers how far it has ever been used, so only memory
+ * reused after a reset, rewind or release is cleared; fresh block memory
+ * from the OS or calloc is known to be zero already.
+ * @param arena Pointer to the arena
+ * @param size Number of bytes to allocate
+ * @return Pointer to zeroed memory, or NULL on failure
+ */
+void *arena_alloc_zeroed(Arena *arena, size_t size);
+
+/**
+ * Allocate a zero-filled array.
+ * @param arena Pointer to the arena
+ * @param count Number of elements
+ * @param size Size of each element
+ * @return Pointer to zeroed memory, or NULL on failure or overflow
+ */
+void *arena_calloc(Arena *arena, size_t count, size_t size);
+
+/**
+ * Allocate several chunks with a single capacity check.
+ * The chunks are laid out back to back, each aligned to ARENA_ALIGNMENT,
+ * and are reserved together so they never straddle a block boundary.
+ * @param arena Pointer to the arena
+ * @param sizes Size of each chunk (a size of 0 yields NULL)
+ * @param count Number of chunks
+ * @param out Receives a pointer per chunk
+ * @return true on success, false on failure
+ */
+bool arena_alloc_batch(Arena *arena, const size_t *sizes, size_t count, void **out);
+
+/**
+ * Allocate count chunks of the same size with a single capacity check.
+ * @param arena Pointer to the arena
+ * @param size Size of each chunk
+ * @param count Number of chunks
+ * @param out Receives a pointer per chunk
+ * @return true on success, false on failure
+ */
+bool arena_alloc_batch_n(Arena *arena, size_t size, size_t count, void **out);
+
+/**
+ * Get room for up to size bytes at the top of the arena without
+ * allocating it. Fill it, then call arena_commit with the bytes actually
+ * used. Any other allocation in between discards the reservation.
+ * @param arena Pointer to the arena
+ * @param size Number of bytes to make room for
+ * @return Pointer to the reserved room, aligned to ARENA_ALIGNMENT, or
+ *         NULL on failure
+ */
+void *arena_reserve(Arena *arena, size_t size);
+
+/**
+ * Allocate the first size bytes of the last arena_reserve.
+ * @param arena Pointer to the arena
+ * @param size Number of bytes used, at most the reserved size
+ * @return Pointer to the allocation (the reserved pointer)
+ */
+void *arena_commit(Arena *arena, size_t size);
 
 /**
  * Reallocate memory within the arena.
- * Note: This may not reuse the old memory location.
+ * If old_ptr is the most recent allocation in the active block it is grown
+ * or shrunk in place; otherwise growing copies into a new allocation.
  * @param arena Pointer to the arena
  * @param old_ptr Pointer to existing memory (can be NULL)
  * @param old_size Size of existing memory
@@ -74,9 +687,40 @@ void *arena_alloc(Arena *arena, size_t size);
  */
 void *arena_realloc(Arena *arena, void *old_ptr, size_t old_size, size_t new_size);
 
+/**
+ * Take a checkpoint of the arena's current allocation position.
+ * @param arena Pointer to the arena
+ * @return Marker to pass to arena_rewind
+ */
+ArenaMark arena_mark(const Arena *arena);
+
+/**
+ * Rewind the arena to a marker, releasing every allocation made since it
+ * was taken. Blocks chained after the marker are kept for reuse.
+ * Markers are invalidated by arena_reset, arena_free, and by rewinding to
+ * an earlier marker.
+ * @param arena Pointer to the arena
+ * @param mark Marker returned by arena_mark on the same arena
+ */
+void arena_rewind(Arena *arena, ArenaMark mark);
+
+/**
+ * Give a chunk back to the arena before the arena is reset.
+ * The most recent allocation in the active block is always reclaimed by
+ * moving the bump offset back. Other chunks are only reused by arenas
+ * created with free_lists set, which hand them out again from arena_alloc;
+ * arena_realloc releases the buffers it moves away from.
+ * @param arena Pointer to the arena
+ * @param ptr Pointer returned by an allocation on this arena (can be NULL)
+ * @param size Size the chunk was allocated with
+ */
+void arena_release(Arena *arena, void *ptr, size_t size);
+
 /**
  * Reset the arena, marking all memory as available for reuse.
- * Does not free the underlying memory blocks.
+ * By default the underlying blocks are kept; the arena's reset_policy can
+ * instead coalesce them into one block sized to the peak usage since the
+ * previous reset, or trim them down to retain_size.
  * @param arena Pointer to the arena
  */
 void arena_reset(Arena *arena);
@@ -88,23 +732,3645 @@ void arena_reset(Arena *arena);
 void arena_free(Arena *arena);
 
 /**
- * Print debug information about the arena.
- * @param arena Pointer to the arena
+ * Initialize an arena that can be shared between threads.
+ * Concurrent arenas always chain blocks; reserve_size is ignored.
+ * @param config Arena options, or NULL for the defaults
+ * @return Initialized concurrent arena
  */
-void arena_print(const Arena *arena);
+ArenaConcurrent arena_concurrent_init(const ArenaConfig *config);
 
 /**
- * Get the total capacity of all blocks in the arena.
- * @param arena Pointer to the arena
- * @return Total capacity in bytes
+ * Allocate memory from a concurrent arena. Safe to call from any number
+ * of threads at once. Memory is aligned to ARENA_ALIGNMENT bytes.
+ * Failures follow the arena's failure policy. An on_failure handler runs
+ * on the failing thread, possibly on several at once, and must not reset
+ * the arena; a true return retries acquiring the block once.
+ * @param arena Pointer to the concurrent arena
+ * @param size Number of bytes to allocate
+ * @return Pointer to allocated memory, or NULL on failure
  */
-size_t arena_total_capacity(const Arena *arena);
+void *arena_concurrent_alloc(ArenaConcurrent *arena, size_t size);
 
 /**
- * Get the total used memory across all blocks in the arena.
- * @param arena Pointer to the arena
- * @return Total used memory in bytes
+ * Reset a concurrent arena, keeping its blocks for reuse; large requests
+ * claim whole empty blocks before acquiring new ones.
+ * Not thread-safe: no thread may be allocating while this runs.
+ * @param arena Pointer to the concurrent arena
  */
-size_t arena_total_used(const Arena *arena);
-	
-#endif // ARENA_H
+void arena_concurrent_reset(ArenaConcurrent *arena);
+
+/**
+ * Free all memory associated with a concurrent arena.
+ * Not thread-safe: no thread may be allocating while this runs.
+ * @param arena Pointer to the concurrent arena
+ */
+void arena_concurrent_free(ArenaConcurrent *arena);
+
+/**
+ * Initialize a frame arena pair.
+ * @param config Options for both arenas, or NULL for the defaults
+ * @return Initialized frame arenas
+ */
+ArenaFrame arena_frame_init(const ArenaConfig *config);
+
+/**
+ * Start a new tick: the current arena becomes the previous one, and the
+ * previous one is reset and becomes current. Memory allocated during the
+ * tick that just ended stays valid until the end of this one.
+ * @param frame Pointer to the frame arenas
+ */
+void arena_frame_tick(ArenaFrame *frame);
+
+/**
+ * Keep an allocation alive for one more tick by copying it into the
+ * current arena. Memory that already lives there is returned as is.
+ * @param frame Pointer to the frame arenas
+ * @param ptr Allocation from the previous or the current tick, or NULL
+ * @param size Size of the allocation
+ * @return Pointer valid until the end of the next tick, NULL for NULL
+ */
+void *arena_frame_promote(ArenaFrame *frame, const void *ptr, size_t size);
+
+/**
+ * Free both arenas of a frame pair.
+ * @param frame Pointer to the frame arenas
+ */
+void arena_frame_free(ArenaFrame *frame);
+
+/**
+ * Get the arena allocations of the current tick come from.
+ * @param frame Pointer to the frame arenas
+ * @return Current arena
+ */
+static inline Arena *arena_frame_current(ArenaFrame *frame) {
+    return &frame->arenas[frame->current];
+}
+
+/**
+ * Get the arena holding the previous tick's allocations.
+ * @param frame Pointer to the frame arenas
+ * @return Previous arena
+ */
+static inline Arena *arena_frame_previous(ArenaFrame *frame) {
+    return &frame->arenas[frame->current ^ 1];
+}
+
+/**
+ * Allocate memory valid until the end of the next tick.
+ * @param frame Pointer to the frame arenas
+ * @param size Number of bytes to allocate
+ * @return Pointer to allocated memory, or NULL on failure
+ */
+static inline void *arena_frame_alloc(ArenaFrame *frame, size_t size) {
+    return arena_alloc(arena_frame_current(frame), size);
+}
+
+/**
+ * Initialize a block pool using the default allocator. To pool blocks
+ * from another allocator, set the pool's allocator before any arena uses it.
+ * @param block_size Capacity of pooled blocks (0 = ARENA_POOL_BLOCK_SIZE)
+ * @return Initialized, empty pool
+ */
+ArenaBlockPool arena_block_pool_init(size_t block_size);
+
+/**
+ * Free every block cached in a pool.
+ * Arenas still bound to the pool must be freed first.
+ * @param pool Pointer to the pool
+ */
+void arena_block_pool_free(ArenaBlockPool *pool);
+
+/**
+ * Count the blocks currently cached in a pool.
+ * @param pool Pointer to the pool
+ * @return Number of cached blocks
+ */
+size_t arena_block_pool_count(const ArenaBlockPool *pool);
+
+/**
+ * Get the calling thread's arena, creating it on first use.
+ * The arena draws its blocks from the given pool; later calls on the same
+ * thread return the same arena and ignore the argument.
+ * @param pool Block pool shared between threads
+ * @return Pointer to the thread's arena
+ */
+Arena *arena_thread(ArenaBlockPool *pool);
+
+/**
+ * Free the calling thread's arena, returning its blocks to the pool.
+ * Call before the thread exits, or its blocks are leaked.
+ */
+void arena_thread_release(void);
+
+/**
+ * Get a backing allocator that places block memory on a NUMA node.
+ * Blocks are mapped directly from the OS and bound with a preferred-node
+ * policy, so they fall back to another node rather than fail when the
+ * node runs out. Allocations smaller than a page, such as block headers,
+ * come from malloc. Huge page and virtual arenas map their blocks
+ * themselves and are not bound.
+ * @param node Node number, or ARENA_NUMA_LOCAL for first-touch placement
+ * @return Allocator for ArenaConfig.allocator or ArenaBlockPool.allocator
+ */
+ArenaAllocator arena_numa_allocator(int node);
+
+/**
+ * Get the number of NUMA nodes on this machine.
+ * @return Node count, 1 where NUMA is unavailable
+ */
+int arena_numa_node_count(void);
+
+/**
+ * Get the NUMA node the calling thread is running on.
+ * @return Node number, 0 where NUMA is unavailable
+ */
+int arena_numa_current_node(void);
+
+/**
+ * Create one block pool per NUMA node, each allocating on its node.
+ * @param block_size Capacity of pooled blocks (0 = ARENA_POOL_BLOCK_SIZE)
+ * @return Initialized set
+ */
+ArenaNumaSet arena_numa_set_init(size_t block_size);
+
+/**
+ * Get the pool for a node, e.g. arena_thread(arena_numa_set_pool(&set,
+ * ARENA_NUMA_LOCAL)) for a thread arena on the calling thread's node.
+ * @param set Pointer to the set
+ * @param node Node number, or ARENA_NUMA_LOCAL for the calling thread's node
+ * @return Pointer to the node's pool
+ */
+ArenaBlockPool *arena_numa_set_pool(ArenaNumaSet *set, int node);
+
+/**
+ * Free every pool in a set.
+ * Arenas still bound to its pools must be freed first.
+ * @param set Pointer to the set
+ */
+void arena_numa_set_free(ArenaNumaSet *set);
+
+/**
+ * Take a snapshot of the arena's statistics.
+ * The counters are copied as is; capacity, used and block_count walk the
+ * block chain.
+ * @param arena Pointer to the arena
+ * @return Statistics snapshot (all zero for NULL)
+ */
+ArenaStats arena_stats(const Arena *arena);
+
+/**
+ * Create an empty trace.
+ * @param capacity Events to keep, rounded up to a power of 2 (0 = 65536)
+ * @return Initialized trace
+ */
+ArenaTrace arena_trace_init(size_t capacity);
+
+/**
+ * Free a trace's events.
+ * @param trace Pointer to the trace
+ */
+void arena_trace_free(ArenaTrace *trace);
+
+/**
+ * Count the events a trace holds, at most its capacity.
+ * @param trace Pointer to the trace
+ * @return Number of events
+ */
+size_t arena_trace_count(const ArenaTrace *trace);
+
+/**
+ * Get a held event, oldest first.
+ * @param trace Pointer to the trace
+ * @param index Index below arena_trace_count
+ * @return Pointer to the event
+ */
+const ArenaTraceEvent *arena_trace_event(const ArenaTrace *trace, size_t index);
+
+/**
+ * Write the held events to a binary trace file, oldest first.
+ * @param trace Pointer to the trace
+ * @param path File to write
+ * @return true on success
+ */
+bool arena_trace_save(const ArenaTrace *trace, const char *path);
+
+/**
+ * Read a trace file written by arena_trace_save. Files whose events have
+ * an unknown op, an alignment above ARENA_MAX_BLOCK_SIZE or a size above
+ * PTRDIFF_MAX are rejected.
+ * @param trace Receives the events; free with arena_trace_free
+ * @param path File to read
+ * @return true on success
+ */
+bool arena_trace_load(ArenaTrace *trace, const char *path);
+
+/**
+ * Run a trace's operations against an arena, e.g. one with a different
+ * growth policy or backend, and leave the outcome in its statistics.
+ * A realloc resizes the most recent allocation when its size matches the
+ * traced old size, the usual growing-buffer pattern, and is replayed as a
+ * fresh allocation otherwise.
+ * @param trace Pointer to the trace
+ * @param arena Arena to replay into
+ */
+void arena_trace_replay(const ArenaTrace *trace, Arena *arena);
+
+/**
+ * Create an arena backed by a memory-mapped file, replacing the file if it
+ * exists. The whole arena is one block of fixed capacity inside the shared
+ * mapping, so allocations land directly in the page cache; the file is
+ * sized up front but stays sparse until pages are touched. Link stored
+ * structures with ArenaOffset, not pointers, and free with arena_free.
+ * @param arena Receives the arena
+ * @param path File to create
+ * @param capacity Bytes available to allocations, rounded up so the file
+ *                 is a whole number of pages
+ * @return true on success, false if the file could not be created or mapped
+ */
+bool arena_create_file(Arena *arena, const char *path, size_t capacity);
+
+/**
+ * Map an image written by arena_create_file and arena_save. Allocations
+ * made before the last save are there at once, with no parsing or copying.
+ * A read-only arena maps the file without write access, so any number of
+ * processes can share its pages; it must not be allocated from or reset.
+ * A writable arena continues allocating where the saved one stopped.
+ * @param arena Receives the arena
+ * @param path File to open
+ * @param read_only Map without write access
+ * @return true on success, false if the file is missing or not an image,
+ *         including one whose root lies outside the saved allocations
+ */
+bool arena_open(Arena *arena, const char *path, bool read_only);
+
+/**
+ * Checkpoint a writable file-backed arena: record its used size in the
+ * header and flush the dirty pages to the file.
+ * @param arena Pointer to the arena
+ * @return true on success, false for other arenas or if the flush failed
+ */
+bool arena_save(Arena *arena);
+
+/**
+ * Record the object an image's structures are reached from, so a process
+ * opening the file can find them with arena_root. The store is a release,
+ * so in a shared-memory arena it publishes everything written before it.
+ * @param arena Pointer to a writable file-backed arena
+ * @param ptr Object inside the arena aligned to ARENA_ALIGNMENT, or NULL
+ */
+void arena_set_root(Arena *arena, const void *ptr);
+
+/**
+ * Get the object recorded by arena_set_root (an acquire load).
+ * @param arena Pointer to a file-backed arena
+ * @return Pointer to the root object, or NULL if none was set
+ */
+void *arena_root(const Arena *arena);
+
+/**
+ * Create a file-backed arena in a POSIX shared memory segment, replacing
+ * any segment of the same name. The creating process is the producer: it
+ * builds messages in place and publishes them with arena_set_root, and
+ * consumers map the same pages with arena_shared_open and read them
+ * without a copy. The segment outlives the arena until
+ * arena_shared_unlink.
+ * @param arena Receives the arena
+ * @param name Segment name, "/name" (a named file mapping on Windows)
+ * @param capacity Bytes available to allocations
+ * @return true on success
+ */
+bool arena_shared_create(Arena *arena, const char *name, size_t capacity);
+
+/**
+ * Attach a consumer to a segment made by arena_shared_create. The arena
+ * reads offsets and follows arena_root but must not be allocated from or
+ * reset; it maps the segment writable only to count itself in readers.
+ * @param arena Receives the arena
+ * @param name Segment name
+ * @return true on success, false if there is no such segment
+ */
+bool arena_shared_open(Arena *arena, const char *name);
+
+/**
+ * Remove a shared memory segment's name. Processes that have it mapped
+ * keep using it; the memory goes once the last one calls arena_free.
+ * @param name Segment name
+ * @return true on success
+ */
+bool arena_shared_unlink(const char *name);
+
+/**
+ * Start reading a shared arena in place. While any reader is inside,
+ * arena_shared_reset refuses to run; a plain arena_reset still can, and
+ * arena_shared_leave then reports that the memory was reused.
+ * @param arena Pointer to a file-backed arena
+ * @return Generation the reads belong to
+ */
+uint64_t arena_shared_enter(Arena *arena);
+
+/**
+ * Finish reading a shared arena.
+ * @param arena Pointer to a file-backed arena
+ * @param generation Value returned by arena_shared_enter
+ * @return true if nothing was reset since arena_shared_enter, so what was
+ *         read is intact; false if it has to be discarded
+ */
+bool arena_shared_leave(Arena *arena, uint64_t generation);
+
+/**
+ * Reset a producer's shared arena, unless a reader is inside.
+ * @param arena Pointer to a writable file-backed arena
+ * @return true if the arena was reset, false if readers are still inside
+ */
+bool arena_shared_reset(Arena *arena);
+
+/**
+ * Convert a pointer into a file-backed arena to an offset.
+ * @param arena Pointer to a file-backed arena
+ * @param ptr Pointer into the arena, or NULL
+ * @return Offset of ptr, 0 for NULL
+ */
+static inline ArenaOffset arena_offset(const Arena *arena, const void *ptr) {
+    return (ptr == NULL) ? 0 : (ArenaOffset)((const uint8_t*)ptr - (const uint8_t*)arena->file);
+}
+
+/**
+ * Convert an offset into a file-backed arena to a pointer.
+ * @param arena Pointer to a file-backed arena
+ * @param offset Offset from arena_offset, or 0
+ * @return Pointer in this process's mapping, NULL for 0
+ */
+static inline void *arena_pointer(const Arena *arena, ArenaOffset offset) {
+    return (offset == 0) ? NULL : (void*)((uint8_t*)arena->file + offset);
+}
+
+/**
+ * Print debug information about the arena.
+ * @param arena Pointer to the arena
+ */
+void arena_print(const Arena *arena);
+
+/**
+ * Get the total capacity of all blocks in the arena.
+ * @param arena Pointer to the arena
+ * @return Total capacity in bytes
+ */
+size_t arena_total_capacity(const Arena *arena);
+
+/**
+ * Get the total used memory across all blocks in the arena.
+ * @param arena Pointer to the arena
+ * @return Total used memory in bytes
+ */
+size_t arena_total_used(const Arena *arena);
+
+/**
+ * Initialize a pool of fixed-size slots on an arena.
+ * @param arena Arena to carve slots from
+ * @param slot_size Size of each slot, rounded up to hold a pointer and
+ *                  keep slots ARENA_ALIGNMENT aligned
+ * @return Initialized pool
+ */
+ArenaPool arena_pool_init(Arena *arena, size_t slot_size);
+
+/**
+ * Allocate a slot from the pool, reusing a freed one if available.
+ * @param pool Pointer to the pool
+ * @return Pointer to the slot, or NULL on failure
+ */
+void *arena_pool_alloc(ArenaPool *pool);
+
+/**
+ * Return a slot to the pool.
+ * @param pool Pointer to the pool
+ * @param ptr Slot returned by arena_pool_alloc on the same pool (can be NULL)
+ */
+void arena_pool_free(ArenaPool *pool, void *ptr);
+
+/**
+ * Forget every freed slot. Call after the backing arena is reset or
+ * rewound past the pool's slots.
+ * @param pool Pointer to the pool
+ */
+void arena_pool_reset(ArenaPool *pool);
+
+/**
+ * Initialize an empty array. Nothing is allocated until the first item.
+ * @param arena Arena to store items in
+ * @param item_size Size of each item
+ * @return Initialized array
+ */
+ArenaArray arena_array_init(Arena *arena, size_t item_size);
+
+/**
+ * Make room for at least capacity items.
+ * @param array Pointer to the array
+ * @param capacity Number of items needed
+ * @return true on success, false on failure
+ */
+bool arena_array_reserve(ArenaArray *array, size_t capacity);
+
+/**
+ * Append one item.
+ * @param array Pointer to the array
+ * @param item Item to copy in, or NULL to leave the slot uninitialized
+ * @return Pointer to the new item, or NULL on failure
+ */
+void *arena_array_push(ArenaArray *array, const void *item);
+
+/**
+ * Append several items.
+ * @param array Pointer to the array
+ * @param items Items to copy in, or NULL to leave the slots uninitialized
+ * @param count Number of items
+ * @return Pointer to the first new item, or NULL on failure
+ */
+void *arena_array_extend(ArenaArray *array, const void *items, size_t count);
+
+/**
+ * Initialize an empty string. Nothing is allocated until the first append.
+ * @param arena Arena to store characters in
+ * @return Initialized string
+ */
+ArenaString arena_string_init(Arena *arena);
+
+/**
+ * Append bytes to a string.
+ * @param string Pointer to the string
+ * @param text Bytes to append
+ * @param length Number of bytes
+ * @return true on success, false on failure
+ */
+bool arena_string_append_n(ArenaString *string, const char *text, size_t length);
+
+/**
+ * Append a NUL-terminated string.
+ * @param string Pointer to the string
+ * @param text Text to append
+ * @return true on success, false on failure
+ */
+bool arena_string_append(ArenaString *string, const char *text);
+
+/**
+ * Append printf-style formatted text.
+ * @param string Pointer to the string
+ * @param format printf format string
+ * @return true on success, false on failure
+ */
+bool arena_string_appendf(ArenaString *string, const char *format, ...);
+
+/**
+ * Append printf-style formatted text from a va_list.
+ * @param string Pointer to the string
+ * @param format printf format string
+ * @param args Format arguments
+ * @return true on success, false on failure
+ */
+bool arena_string_vappendf(ArenaString *string, const char *format, va_list args);
+
+/**
+ * Copy part of a string into the arena as a new NUL-terminated string.
+ * The range is clamped to the string's length.
+ * @param string Pointer to the string
+ * @param start Offset of the first byte
+ * @param length Number of bytes
+ * @return Pointer to the copy, or NULL on failure
+ */
+char *arena_string_slice(const ArenaString *string, size_t start, size_t length);
+
+/**
+ * Hash a byte string.
+ * @param data Bytes to hash
+ * @param length Number of bytes
+ * @return 64-bit hash
+ */
+uint64_t arena_hash(const void *data, size_t length);
+
+/**
+ * Initialize an empty map. Nothing is allocated until the first insert.
+ * @param arena Arena to store buckets and keys in
+ * @param capacity Expected number of keys, or 0
+ * @return Initialized map
+ */
+ArenaMap arena_map_init(Arena *arena, size_t capacity);
+
+/**
+ * Find the entry for a key.
+ * The pointer is valid until the next insert into the map.
+ * @param map Pointer to the map
+ * @param key Key bytes
+ * @param key_length Number of key bytes
+ * @return Pointer to the entry, or NULL if the key is not present
+ */
+ArenaMapEntry *arena_map_find(const ArenaMap *map, const void *key, size_t key_length);
+
+/**
+ * Find the entry for a key, adding it with a NULL value if missing.
+ * New keys are copied into the arena. The pointer is valid until the
+ * next insert into the map.
+ * @param map Pointer to the map
+ * @param key Key bytes
+ * @param key_length Number of key bytes
+ * @return Pointer to the entry, or NULL on failure
+ */
+ArenaMapEntry *arena_map_insert(ArenaMap *map, const void *key, size_t key_length);
+
+/**
+ * Get the value stored for a key.
+ * @param map Pointer to the map
+ * @param key Key bytes
+ * @param key_length Number of key bytes
+ * @return Stored value, or NULL if the key is not present
+ */
+void *arena_map_get(const ArenaMap *map, const void *key, size_t key_length);
+
+/**
+ * Store a value for a key, replacing any previous value.
+ * @param map Pointer to the map
+ * @param key Key bytes
+ * @param key_length Number of key bytes
+ * @param value Value to store
+ * @return true on success, false on failure
+ */
+bool arena_map_put(ArenaMap *map, const void *key, size_t key_length, void *value);
+
+/**
+ * Remove a key from the map. Its copy is given back with arena_release:
+ * arenas with free lists reuse it for later keys, others only reclaim it
+ * when it is the most recent allocation and keep it until the next reset
+ * otherwise.
+ * @param map Pointer to the map
+ * @param key Key bytes
+ * @param key_length Number of key bytes
+ * @return true if the key was present
+ */
+bool arena_map_remove(ArenaMap *map, const void *key, size_t key_length);
+
+/**
+ * Initialize an empty intern table.
+ * @param arena Arena to store the strings in
+ * @param capacity Expected number of distinct strings, or 0
+ * @return Initialized intern table
+ */
+ArenaIntern arena_intern_init(Arena *arena, size_t capacity);
+
+/**
+ * Intern a byte string.
+ * @param table Pointer to the intern table
+ * @param string Bytes of the string
+ * @param length Number of bytes
+ * @return Stable, NUL-terminated copy shared by all equal strings, or NULL
+ *         on failure
+ */
+const char *arena_intern_n(ArenaIntern *table, const char *string, size_t length);
+
+/**
+ * Intern a NUL-terminated string.
+ * @param table Pointer to the intern table
+ * @param string String to intern
+ * @return Stable copy shared by all equal strings, or NULL on failure
+ */
+const char *arena_intern(ArenaIntern *table, const char *string);
+
+/**
+ * Look up a string without interning it.
+ * @param table Pointer to the intern table
+ * @param string Bytes of the string
+ * @param length Number of bytes
+ * @return The interned copy, or NULL if the string was never interned
+ */
+const char *arena_intern_find(const ArenaIntern *table, const char *string, size_t length);
+
+
+#ifdef __cplusplus
+}
+#endif
+	
+#endif // ARENA_H
+
+#ifdef ARENA_IMPLEMENTATION
+#ifndef ARENA_IMPLEMENTATION_INCLUDED
+#define ARENA_IMPLEMENTATION_INCLUDED
+
+/*
+ * Arena Allocator Library - Implementation
+ * 
+ * Compiled into the one translation unit that defines ARENA_IMPLEMENTATION.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#define ARENA_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define ARENA_ASAN 1
+#endif
+#endif
+
+#if defined(ARENA_DEBUG) && defined(ARENA_ASAN)
+#include <sanitizer/asan_interface.h>
+#define ARENA_POISON(ptr, size) ASAN_POISON_MEMORY_REGION((ptr), (size))
+#define ARENA_UNPOISON(ptr, size) ASAN_UNPOISON_MEMORY_REGION((ptr), (size))
+#else
+#define ARENA_POISON(ptr, size) ((void)(ptr), (void)(size))
+#define ARENA_UNPOISON(ptr, size) ((void)(ptr), (void)(size))
+#endif
+
+/**
+ * Report a fatal error and abort. Only async-signal-safe calls are made,
+ * with no stdio and no heap, so this is safe in a signal handler or while
+ * the heap is exhausted.
+ * @param prefix Text before the number
+ * @param number Size to report
+ * @param suffix Text after the number
+ */
+static void arena_fatal(const char *prefix, size_t number, const char *suffix) {
+    char message[160];
+    size_t length = 0;
+    const char *parts[] = { "Arena: ", prefix };
+    for (size_t i = 0; i < 2; i++) {
+        for (const char *c = parts[i]; *c != '\0' && length < 64; c++) {
+            message[length++] = *c;
+        }
+    }
+    char digits[24];
+    size_t count = 0;
+    do {
+        digits[count++] = (char)('0' + number % 10);
+        number /= 10;
+    } while (number != 0);
+    while (count != 0) {
+        message[length++] = digits[--count];
+    }
+    for (const char *c = suffix; *c != '\0' && length < sizeof(message) - 1; c++) {
+        message[length++] = *c;
+    }
+    message[length++] = '\n';
+#ifdef _WIN32
+    DWORD written;
+    WriteFile(GetStdHandle(STD_ERROR_HANDLE), message, (DWORD)length, &written, NULL);
+#else
+    ssize_t written = write(2, message, length);
+    (void)written;
+#endif
+    abort();
+}
+
+/**
+ * Apply an arena's failure policy outside the allocation slow path, where
+ * every policy but ARENA_FAIL_ABORT makes the operation fail softly.
+ * @param arena Pointer to the arena
+ * @param size Number of bytes that could not be allocated
+ */
+static void arena_fail(const Arena *arena, size_t size) {
+    if (arena->failure_policy == ARENA_FAIL_ABORT) {
+        arena_fatal("Failed to allocate ", size, " bytes");
+    }
+}
+
+#ifndef ARENA_ALLOC
+/**
+ * Custom malloc wrapper with error handling, for the library's own
+ * bookkeeping allocations.
+ * @param size Number of bytes to allocate
+ * @return Pointer to allocated memory
+ */
+static void *arena_malloc(size_t size) {
+    void *ptr = malloc(size);
+    if (ptr == NULL) {
+        arena_fatal("Failed to allocate ", size, " bytes");
+    }
+    return ptr;
+}
+#define ARENA_ALLOC arena_malloc
+#define ARENA_ALLOC_IS_MALLOC
+#endif // ARENA_ALLOC
+
+// Override ARENA_FREE together with ARENA_ALLOC
+#ifndef ARENA_FREE
+#define ARENA_FREE free
+#endif // ARENA_FREE
+
+static void *arena_default_alloc(void *context, size_t size) {
+    (void)context;
+#ifdef ARENA_ALLOC_IS_MALLOC
+    // Blocks are allowed to fail; arena_backing_alloc or the arena's
+    // failure policy decides what happens then
+    return malloc(size);
+#else
+    return ARENA_ALLOC(size);
+#endif
+}
+
+static void arena_default_free(void *context, void *ptr, size_t size) {
+    (void)context;
+    (void)size;
+    ARENA_FREE(ptr);
+}
+
+#ifdef ARENA_ALLOC_IS_MALLOC
+static void *arena_default_alloc_zeroed(void *context, size_t size) {
+    (void)context;
+    return calloc(1, size);
+}
+#endif
+
+/** Allocator used when none is configured */
+static const ArenaAllocator arena_default_allocator = {
+    arena_default_alloc,
+    arena_default_free,
+    NULL,
+#ifdef ARENA_ALLOC_IS_MALLOC
+    arena_default_alloc_zeroed,
+#else
+    // calloc memory must not reach a custom ARENA_FREE
+    NULL,
+#endif
+};
+
+/**
+ * Allocate from a backing allocator, failing hard like arena_malloc.
+ * @param allocator Backing allocator
+ * @param size Number of bytes to allocate
+ * @return Pointer to allocated memory
+ */
+static void *arena_backing_alloc(const ArenaAllocator *allocator, size_t size) {
+    void *ptr = allocator->alloc(allocator->context, size);
+    if (ptr == NULL) {
+        arena_fatal("Failed to allocate ", size, " bytes");
+    }
+    return ptr;
+}
+
+/**
+ * Free memory obtained from arena_backing_alloc.
+ * @param allocator Backing allocator the memory came from
+ * @param ptr Pointer to the memory
+ * @param size Size it was allocated with
+ */
+static inline void arena_backing_free(const ArenaAllocator *allocator, void *ptr, size_t size) {
+    allocator->free(allocator->context, ptr, size);
+}
+
+/**
+ * Align a size to the specified alignment.
+ * @param size Size to align
+ * @param alignment Alignment boundary (must be power of 2)
+ * @return Aligned size
+ */
+static inline size_t arena_align_size(size_t size, size_t alignment) {
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * Get the used bytes of a block. Concurrent allocation can push a block's
+ * offset past its capacity while racing for its last bytes.
+ * @param block Pointer to the block
+ * @return Used bytes, at most the block's capacity
+ */
+static inline size_t arena_block_used(const ArenaBlock *block) {
+    return (block->size < block->capacity) ? block->size : block->capacity;
+}
+
+/**
+ * Mark memory as handed out in ARENA_DEBUG builds: unpoison it and fill
+ * it with ARENA_DEBUG_ALLOC_BYTE.
+ * @param ptr Start of the memory
+ * @param size Number of bytes
+ */
+static inline void arena_debug_fresh(void *ptr, size_t size) {
+#ifdef ARENA_DEBUG
+    ARENA_UNPOISON(ptr, size);
+    memset(ptr, ARENA_DEBUG_ALLOC_BYTE, size);
+#else
+    (void)ptr;
+    (void)size;
+#endif
+}
+
+/**
+ * Mark memory as given back in ARENA_DEBUG builds: fill it with
+ * ARENA_DEBUG_FREE_BYTE and poison it.
+ * @param ptr Start of the memory
+ * @param size Number of bytes
+ */
+static inline void arena_debug_dead(void *ptr, size_t size) {
+#ifdef ARENA_DEBUG
+    ARENA_UNPOISON(ptr, size);
+    memset(ptr, ARENA_DEBUG_FREE_BYTE, size);
+    ARENA_POISON(ptr, size);
+#else
+    (void)ptr;
+    (void)size;
+#endif
+}
+
+/** Offset of a heap block's data from its header, keeping malloc's 16-byte alignment */
+#define ARENA_BLOCK_HEADER_SIZE ((sizeof(ArenaBlock) + 15) & ~(size_t)15)
+
+/**
+ * Allocate a new, empty block with its header and data in one allocation.
+ * @param allocator Backing allocator for the block
+ * @param capacity Capacity of the block in bytes
+ * @param zeroed Get zero-filled memory if the allocator offers it
+ * @return Pointer to the new block, or NULL if the allocator failed
+ */
+static ArenaBlock *arena_block_new(const ArenaAllocator *allocator, size_t capacity, bool zeroed) {
+    if (capacity > SIZE_MAX - ARENA_BLOCK_HEADER_SIZE) {
+        return NULL;
+    }
+    
+    size_t size = ARENA_BLOCK_HEADER_SIZE + capacity;
+    bool cleared = zeroed && allocator->alloc_zeroed != NULL;
+    ArenaBlock *block = (ArenaBlock*)(cleared ? allocator->alloc_zeroed(allocator->context, size)
+                                              : allocator->alloc(allocator->context, size));
+    if (block == NULL) {
+        return NULL;
+    }
+    block->dirty = cleared ? 0 : capacity;
+    block->next = NULL;
+    block->capacity = capacity;
+    block->size = 0;
+    block->data = (uint8_t*)block + ARENA_BLOCK_HEADER_SIZE;
+    block->reserved = 0;
+    return block;
+}
+
+/**
+ * Fold a block's size into its dirty mark before the size goes down,
+ * so everything ever handed out stays known as possibly non-zero.
+ * @param block Pointer to the block
+ */
+static inline void arena_block_mark_dirty(ArenaBlock *block) {
+    size_t used = arena_block_used(block);
+    if (used > block->dirty) {
+        block->dirty = used;
+    }
+}
+
+/**
+ * Get the OS page size.
+ * @return Page size in bytes
+ */
+static size_t arena_os_page_size(void) {
+    static size_t page;
+    if (page == 0) {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        page = info.dwPageSize;
+#else
+        page = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    }
+    return page;
+}
+
+/**
+ * Get the granularity virtual memory is committed in.
+ * @return ARENA_COMMIT_SIZE rounded up to the OS page size
+ */
+static size_t arena_commit_granularity(void) {
+    static size_t granularity;
+    if (granularity == 0) {
+        granularity = arena_align_size(ARENA_COMMIT_SIZE, arena_os_page_size());
+    }
+    return granularity;
+}
+
+/**
+ * Reserve address space without backing it with memory.
+ * @param size Number of bytes to reserve (multiple of the page size)
+ * @return Start of the reserved range, or NULL on failure
+ */
+static void *arena_os_reserve(size_t size) {
+#ifdef _WIN32
+    return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void *ptr = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return (ptr == MAP_FAILED) ? NULL : ptr;
+#endif
+}
+
+/**
+ * Back part of a reserved range with readable, writable memory.
+ * @return true on success
+ */
+static bool arena_os_commit(void *ptr, size_t size) {
+#ifdef _WIN32
+    return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    return mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+/**
+ * Return the memory behind part of a reserved range to the OS, keeping
+ * the address space reserved.
+ */
+static void arena_os_decommit(void *ptr, size_t size) {
+#ifdef _WIN32
+    VirtualFree(ptr, size, MEM_DECOMMIT);
+#else
+    madvise(ptr, size, MADV_DONTNEED);
+    mprotect(ptr, size, PROT_NONE);
+#endif
+}
+
+/**
+ * Release a reserved range entirely.
+ */
+static void arena_os_release(void *ptr, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, size);
+#endif
+}
+
+/**
+ * Map readable, writable memory placed on a NUMA node.
+ * @param size Number of bytes to map
+ * @param node Node number, or ARENA_NUMA_LOCAL for first-touch placement
+ * @return Start of the mapping, or NULL on failure
+ */
+static void *arena_os_map_node(size_t size, int node) {
+#ifdef _WIN32
+    if (node == ARENA_NUMA_LOCAL) {
+        return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+    return VirtualAllocExNuma(GetCurrentProcess(), NULL, size, MEM_RESERVE | MEM_COMMIT,
+                              PAGE_READWRITE, (DWORD)node);
+#else
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        return NULL;
+    }
+#if defined(__linux__) && defined(SYS_mbind)
+    // Pages are not touched yet, so the policy decides where they land.
+    // Failure (no such node, no NUMA support) leaves the default policy.
+    enum { MPOL_PREFERRED_ = 1, MPOL_LOCAL_ = 4 };
+    if (node == ARENA_NUMA_LOCAL) {
+        syscall(SYS_mbind, ptr, size, MPOL_LOCAL_, NULL, 0UL, 0U);
+    } else if (node >= 0 && node < ARENA_NUMA_MAX_NODES) {
+        unsigned long mask[ARENA_NUMA_MAX_NODES / (8 * sizeof(unsigned long)) + 1] = {0};
+        mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+        syscall(SYS_mbind, ptr, size, MPOL_PREFERRED_, mask, (unsigned long)ARENA_NUMA_MAX_NODES + 1, 0U);
+    }
+#else
+    (void)node;
+#endif
+    return ptr;
+#endif
+}
+
+/**
+ * Size of the huge pages an arena asked for.
+ * @param huge_pages Huge page mode
+ * @return Page size in bytes, or 0 for normal pages
+ */
+static size_t arena_huge_page_size(ArenaHugePages huge_pages) {
+    switch (huge_pages) {
+    case ARENA_HUGE_PAGES_2MB: return (size_t)2 * 1024 * 1024;
+    case ARENA_HUGE_PAGES_1GB: return (size_t)1024 * 1024 * 1024;
+    default: return 0;
+    }
+}
+
+/**
+ * Map memory for a block on huge pages. Tries explicit huge pages first,
+ * then transparent huge pages on a huge-page aligned range, and finally
+ * settles for normal pages.
+ * @param size Number of bytes to map (multiple of the huge page size)
+ * @param huge_pages Huge page mode
+ * @return Start of the mapping, or NULL on failure
+ */
+static void *arena_os_map_huge(size_t size, ArenaHugePages huge_pages) {
+#ifdef _WIN32
+    (void)huge_pages;
+    return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    size_t page = arena_huge_page_size(huge_pages);
+    int prot = PROT_READ | PROT_WRITE;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    
+#ifdef MAP_HUGETLB
+#ifdef MAP_HUGE_SHIFT
+    int page_flag = (huge_pages == ARENA_HUGE_PAGES_1GB) ? (30 << MAP_HUGE_SHIFT) : (21 << MAP_HUGE_SHIFT);
+#else
+    int page_flag = 0;
+#endif
+    void *ptr = mmap(NULL, size, prot, flags | MAP_HUGETLB | page_flag, -1, 0);
+    if (ptr != MAP_FAILED) {
+        return ptr;
+    }
+#endif
+    
+    // Over-map so the range can be trimmed to a huge page boundary
+    uint8_t *raw = (uint8_t*)mmap(NULL, size + page, prot, flags, -1, 0);
+    if (raw == (uint8_t*)MAP_FAILED) {
+        return NULL;
+    }
+    uint8_t *aligned = (uint8_t*)arena_align_size((uintptr_t)raw, page);
+    if (aligned > raw) {
+        munmap(raw, (size_t)(aligned - raw));
+    }
+    if (aligned + size < raw + size + page) {
+        munmap(aligned + size, (size_t)(raw + size + page - (aligned + size)));
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+    return aligned;
+#endif
+}
+
+/**
+ * Map a file shared, so stores go to the page cache and every process
+ * mapping the file sees the same pages.
+ * @param path File to map, or shared memory segment name
+ * @param size Size to create the file with, or 0 to map an existing file
+ * @param read_only Map without write access (existing files only)
+ * @param shared_memory Map a shared memory segment instead of a file
+ * @param length Receives the length of the mapping
+ * @return Start of the mapping, or NULL on failure
+ */
+static void *arena_os_map_file(const char *path, size_t size, bool read_only,
+                               bool shared_memory, size_t *length) {
+#ifdef _WIN32
+    if (shared_memory) {
+        // Named mappings backed by the paging file stand in for shm segments
+        DWORD access = read_only ? FILE_MAP_READ : FILE_MAP_WRITE;
+        HANDLE segment = size ? CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                                   (DWORD)((uint64_t)size >> 32), (DWORD)size, path)
+                              : OpenFileMappingA(access, FALSE, path);
+        if (segment == NULL) {
+            return NULL;
+        }
+        void *view = MapViewOfFile(segment, access, 0, 0, size);
+        CloseHandle(segment);
+        if (view != NULL && size == 0) {
+            MEMORY_BASIC_INFORMATION info;
+            VirtualQuery(view, &info, sizeof(info));
+            size = info.RegionSize;
+        }
+        *length = size;
+        return view;
+    }
+    HANDLE file = CreateFileA(path, read_only ? GENERIC_READ : (GENERIC_READ | GENERIC_WRITE),
+                              FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              size ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    if (size == 0) {
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size)) {
+            CloseHandle(file);
+            return NULL;
+        }
+        size = (size_t)file_size.QuadPart;
+    }
+    void *ptr = NULL;
+    HANDLE mapping = (size == 0) ? NULL :
+        CreateFileMappingA(file, NULL, read_only ? PAGE_READONLY : PAGE_READWRITE,
+                           (DWORD)((uint64_t)size >> 32), (DWORD)size, NULL);
+    if (mapping != NULL) {
+        ptr = MapViewOfFile(mapping, read_only ? FILE_MAP_READ : FILE_MAP_WRITE, 0, 0, size);
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+#else
+    int flags = size ? (O_RDWR | O_CREAT | O_TRUNC) : (read_only ? O_RDONLY : O_RDWR);
+    int fd = shared_memory ? shm_open(path, flags, 0644) : open(path, flags, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (size != 0) {
+        // A fresh file is extended without writing, so it starts sparse
+        if (ftruncate(fd, (off_t)size) != 0) {
+            size = 0;
+        }
+    } else if (fstat(fd, &st) == 0) {
+        size = (size_t)st.st_size;
+    }
+    void *ptr = NULL;
+    if (size != 0) {
+        ptr = mmap(NULL, size, read_only ? PROT_READ : (PROT_READ | PROT_WRITE), MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED) {
+            ptr = NULL;
+        }
+    }
+    // The mapping keeps the file open
+    close(fd);
+#endif
+    *length = size;
+    return ptr;
+}
+
+/**
+ * Write a file mapping's dirty pages back to the file.
+ * @return true on success
+ */
+static bool arena_os_sync_file(void *ptr, size_t size) {
+#ifdef _WIN32
+    return FlushViewOfFile(ptr, size) != 0;
+#else
+    return msync(ptr, size, MS_SYNC) == 0;
+#endif
+}
+
+/**
+ * Unmap a file mapped by arena_os_map_file.
+ */
+static void arena_os_unmap_file(void *ptr, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(ptr);
+#else
+    munmap(ptr, size);
+#endif
+}
+
+/**
+ * Create a block on huge pages.
+ * @param allocator Backing allocator for the block header
+ * @param capacity Minimum capacity, rounded up to the huge page size
+ * @param huge_pages Huge page mode
+ * @return Pointer to the new block, or NULL if the mapping failed
+ */
+static ArenaBlock *arena_block_map_huge(const ArenaAllocator *allocator, size_t capacity,
+                                        ArenaHugePages huge_pages) {
+    capacity = arena_align_size(capacity, arena_huge_page_size(huge_pages));
+    uint8_t *data = (uint8_t*)arena_os_map_huge(capacity, huge_pages);
+    if (data == NULL) {
+        return NULL;
+    }
+    
+    ArenaBlock *block = (ArenaBlock*)allocator->alloc(allocator->context, sizeof(ArenaBlock));
+    if (block == NULL) {
+        arena_os_release(data, capacity);
+        return NULL;
+    }
+    block->next = NULL;
+    block->capacity = capacity;
+    block->size = 0;
+    block->data = data;
+    block->reserved = capacity;
+    block->dirty = 0;
+    return block;
+}
+
+/**
+ * Create a block over a reserved virtual range. Only the first commit
+ * bytes are backed by memory; the rest is committed as the block fills.
+ * @param arena Pointer to the arena, for its reservation and page options
+ * @param commit Number of bytes to commit up front
+ * @return Pointer to the new block, or NULL if the OS refused
+ */
+static ArenaBlock *arena_block_reserve(const Arena *arena, size_t commit) {
+    size_t granularity = arena_commit_granularity();
+    size_t reserve = arena_align_size(arena->reserve_size, granularity);
+    commit = arena_align_size(commit, granularity);
+    if (commit > reserve) {
+        commit = reserve;
+    }
+    
+    uint8_t *data = (uint8_t*)arena_os_reserve(reserve);
+    if (data == NULL) {
+        return NULL;
+    }
+#if defined(MADV_HUGEPAGE) && !defined(_WIN32)
+    if (arena->huge_pages != ARENA_HUGE_PAGES_NONE) {
+        madvise(data, reserve, MADV_HUGEPAGE);
+    }
+#endif
+    ArenaBlock *block = NULL;
+    if (arena_os_commit(data, commit)) {
+        block = (ArenaBlock*)arena->allocator.alloc(arena->allocator.context, sizeof(ArenaBlock));
+    }
+    if (block == NULL) {
+        arena_os_release(data, reserve);
+        return NULL;
+    }
+    ARENA_POISON(data, commit);
+    block->next = NULL;
+    block->capacity = commit;
+    block->size = 0;
+    block->data = data;
+    block->reserved = reserve;
+    block->dirty = 0;
+    return block;
+}
+
+/**
+ * Commit more of a virtual block so it holds at least size bytes.
+ * @param block Pointer to a block created by arena_block_reserve
+ * @param size Number of bytes the block must hold
+ * @return true if the block now holds size bytes, false if that exceeds
+ *         its reservation
+ */
+static bool arena_block_commit(ArenaBlock *block, size_t size) {
+    if (size <= block->capacity) {
+        return true;
+    }
+    if (size > block->reserved) {
+        return false;
+    }
+    
+    size_t capacity = arena_align_size(size, arena_commit_granularity());
+    if (capacity > block->reserved) {
+        capacity = block->reserved;
+    }
+    if (!arena_os_commit(&block->data[block->capacity], capacity - block->capacity)) {
+        return false;
+    }
+    ARENA_POISON(&block->data[block->capacity], capacity - block->capacity);
+    block->capacity = capacity;
+    return true;
+}
+
+/**
+ * Free a block and its memory.
+ * @param allocator Backing allocator the block came from
+ * @param block Pointer to the block
+ */
+static void arena_block_delete(const ArenaAllocator *allocator, ArenaBlock *block) {
+    // Shadow memory outlives the mapping, so clear it for whoever maps the range next
+    ARENA_UNPOISON(block->data, block->reserved ? block->reserved : block->capacity);
+    if (block->reserved != 0) {
+        arena_os_release(block->data, block->reserved);
+        arena_backing_free(allocator, block, sizeof(ArenaBlock));
+    } else {
+        arena_backing_free(allocator, block, ARENA_BLOCK_HEADER_SIZE + block->capacity);
+    }
+}
+
+/**
+ * Serialize pops from a pool. Pushes stay lock-free; with a single popper
+ * at a time the head's next pointer cannot change under a pop, which rules
+ * out the ABA problem of a plain lock-free stack.
+ */
+static void arena_block_pool_lock(ArenaBlockPool *pool) {
+    while (__atomic_test_and_set(&pool->pop_lock, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&pool->pop_lock, __ATOMIC_RELAXED)) {
+        }
+    }
+}
+
+static void arena_block_pool_unlock(ArenaBlockPool *pool) {
+    __atomic_clear(&pool->pop_lock, __ATOMIC_RELEASE);
+}
+
+/**
+ * Push a block onto a pool's free-list.
+ * @param pool Pointer to the pool
+ * @param block Block to recycle; must have the pool's block size
+ */
+static void arena_block_pool_push(ArenaBlockPool *pool, ArenaBlock *block) {
+    arena_block_mark_dirty(block);
+    block->size = 0;
+    ArenaBlock *head = __atomic_load_n(&pool->free, __ATOMIC_RELAXED);
+    do {
+        block->next = head;
+    } while (!__atomic_compare_exchange_n(&pool->free, &head, block, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * Pop a block from a pool's free-list.
+ * @param pool Pointer to the pool
+ * @return Recycled block, or NULL if the pool is empty
+ */
+static ArenaBlock *arena_block_pool_pop(ArenaBlockPool *pool) {
+    if (__atomic_load_n(&pool->free, __ATOMIC_RELAXED) == NULL) {
+        return NULL;
+    }
+    
+    arena_block_pool_lock(pool);
+    ArenaBlock *head = __atomic_load_n(&pool->free, __ATOMIC_ACQUIRE);
+    while (head != NULL &&
+           !__atomic_compare_exchange_n(&pool->free, &head, head->next, true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+    }
+    arena_block_pool_unlock(pool);
+    
+    if (head != NULL) {
+        head->next = NULL;
+    }
+    return head;
+}
+
+/**
+ * Get a block for an arena, recycling one from its pool when possible.
+ * @param arena Pointer to the arena
+ * @param capacity Minimum capacity of the block
+ * @return Pointer to an empty block, or NULL if no memory could be had
+ */
+static ArenaBlock *arena_block_acquire(Arena *arena, size_t capacity, bool zeroed) {
+    ArenaBlock *block;
+    if (arena->huge_pages != ARENA_HUGE_PAGES_NONE) {
+        block = arena_block_map_huge(&arena->allocator, capacity, arena->huge_pages);
+    } else if (arena->pool == NULL || capacity > arena->pool->block_size) {
+        // Pool-sized blocks always come from the pool's allocator, everything
+        // else from the arena's
+        block = arena_block_new(&arena->allocator, capacity, zeroed);
+    } else {
+        block = arena_block_pool_pop(arena->pool);
+        if (block == NULL) {
+            block = arena_block_new(&arena->pool->allocator, arena->pool->block_size, zeroed);
+        }
+    }
+    
+    if (block == NULL) {
+        return NULL;
+    }
+    
+    // Atomic because concurrent arenas acquire blocks from many threads
+    __atomic_fetch_add(&arena->stats.blocks_created, 1, __ATOMIC_RELAXED);
+    // Nothing in a fresh block is handed out yet
+    ARENA_POISON(block->data, block->capacity);
+    return block;
+}
+
+/**
+ * Give a block back, to the arena's pool if it came from there.
+ * @param arena Pointer to the arena
+ * @param block Block to release
+ */
+static void arena_block_release(Arena *arena, ArenaBlock *block) {
+    if (arena->pool != NULL && block->capacity == arena->pool->block_size && block->reserved == 0) {
+        arena_block_pool_push(arena->pool, block);
+    } else {
+        arena_block_delete(&arena->allocator, block);
+    }
+}
+
+ArenaBlockPool arena_block_pool_init(size_t block_size) {
+    if (block_size == 0) {
+        block_size = ARENA_POOL_BLOCK_SIZE;
+    }
+    
+    ArenaBlockPool pool = {
+        .free = NULL,
+        .block_size = arena_align_size(block_size, ARENA_ALIGNMENT),
+        .pop_lock = false,
+        .allocator = arena_default_allocator,
+    };
+    return pool;
+}
+
+void arena_block_pool_free(ArenaBlockPool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+    
+    ArenaBlock *current = __atomic_exchange_n(&pool->free, NULL, __ATOMIC_ACQUIRE);
+    while (current != NULL) {
+        ArenaBlock *next = current->next;
+        arena_block_delete(&pool->allocator, current);
+        current = next;
+    }
+}
+
+size_t arena_block_pool_count(const ArenaBlockPool *pool) {
+    if (pool == NULL) {
+        return 0;
+    }
+    
+    size_t count = 0;
+    const ArenaBlock *current = __atomic_load_n(&pool->free, __ATOMIC_ACQUIRE);
+    while (current != NULL) {
+        count++;
+        current = current->next;
+    }
+    return count;
+}
+
+Arena arena_init(size_t capacity) {
+    ArenaConfig config = { .capacity = capacity };
+    return arena_init_config(&config);
+}
+
+Arena arena_init_config(const ArenaConfig *config) {
+    ArenaConfig defaults = {0};
+    if (config == NULL) {
+        config = &defaults;
+    }
+    
+    size_t capacity = config->capacity ? config->capacity : ARENA_INIT_SIZE;
+    Arena arena = {
+        .block_size = capacity,
+        .min_block_size = config->min_block_size ? config->min_block_size : ARENA_INIT_SIZE,
+        .max_block_size = config->max_block_size ? config->max_block_size : ARENA_MAX_BLOCK_SIZE,
+        .growth_factor = (config->growth_factor >= 1.0) ? config->growth_factor : ARENA_GROWTH_FACTOR,
+        .pool = config->pool,
+        .retain_size = config->retain_size ? config->retain_size : ARENA_COMMIT_SIZE,
+        .reserve_size = config->reserve_size,
+        .huge_pages = config->huge_pages,
+        .reset_policy = config->reset_policy,
+        .allocator = config->allocator.alloc ? config->allocator : arena_default_allocator,
+        .trace = config->trace,
+        .failure_policy = config->failure_policy,
+        .on_failure = config->on_failure,
+        .failure_context = config->failure_context,
+        .emergency_size = config->emergency_size ? config->emergency_size : ARENA_POOL_BLOCK_SIZE,
+    };
+    if (config->free_lists) {
+        // Without them the arena still works; released chunks just aren't reused
+        size_t size = sizeof(void*) * ARENA_SIZE_CLASSES;
+        arena.free_lists = (void**)arena.allocator.alloc(arena.allocator.context, size);
+        if (arena.free_lists == NULL) {
+            arena_fail(&arena, size);
+        } else {
+            memset(arena.free_lists, 0, size);
+        }
+    }
+    if (arena.max_block_size < arena.min_block_size) {
+        arena.max_block_size = arena.min_block_size;
+    }
+    if (arena.pool != NULL) {
+        // Pooled blocks are uniform, so every regular block is pool-sized
+        arena.min_block_size = arena.pool->block_size;
+        arena.max_block_size = arena.pool->block_size;
+    }
+    
+    if (arena.reserve_size != 0) {
+        arena.first = arena_block_reserve(&arena, capacity);
+        arena.stats.blocks_created = (arena.first != NULL);
+    } else {
+        arena.first = arena_block_acquire(&arena, capacity, false);
+    }
+    if (arena.failure_policy == ARENA_FAIL_EMERGENCY) {
+        // Never from the pool or a reservation, which are what runs out
+        arena.emergency = arena_block_new(&arena.allocator, arena.emergency_size, false);
+        if (arena.emergency != NULL) {
+            arena.stats.blocks_created++;
+            ARENA_POISON(arena.emergency->data, arena.emergency->capacity);
+        }
+    }
+    if (arena.first == NULL) {
+        // Other policies leave an empty arena; allocating retries the block
+        arena_fail(&arena, capacity);
+    }
+    arena.current = arena.first;
+    return arena;
+}
+
+/**
+ * Grow a block size by the arena's growth policy.
+ * @param arena Pointer to the arena
+ * @param previous Capacity of the previous policy-sized block
+ * @return Capacity clamped to [min_block_size, max_block_size]
+ */
+static size_t arena_grow_size(const Arena *arena, size_t previous) {
+    size_t capacity = arena->max_block_size;
+    if ((double)previous * arena->growth_factor < (double)arena->max_block_size) {
+        capacity = (size_t)((double)previous * arena->growth_factor);
+    }
+    if (capacity < arena->min_block_size) {
+        capacity = arena->min_block_size;
+    }
+    return arena_align_size(capacity, ARENA_ALIGNMENT);
+}
+
+/**
+ * Compute the capacity of the next chained block.
+ * @param arena Pointer to the arena
+ * @param size Aligned size of the request that triggered the growth
+ * @return Capacity of the block to create
+ */
+static size_t arena_next_block_size(Arena *arena, size_t size) {
+    if (size > arena->max_block_size) {
+        // Oversized requests get a dedicated block and don't move the policy
+        return size;
+    }
+    
+    size_t capacity = arena_grow_size(arena, arena->block_size);
+    arena->block_size = capacity;
+    return (capacity < size) ? size : capacity;
+}
+
+/**
+ * Move to the next empty block that fits, or create one.
+ * @param arena Pointer to the arena
+ * @param size Number of bytes to allocate
+ * @param alignment Alignment boundary (must be power of 2)
+ * @param zeroed Prefer zero-filled memory for a new block
+ * @return Pointer to allocated memory, or NULL if no memory could be had
+ */
+static void *arena_alloc_try_grow(Arena *arena, size_t size, size_t alignment, bool zeroed) {
+    ArenaBlock *current = arena->current;
+    
+    if (arena->reserve_size != 0) {
+        // Virtual arenas grow in place by committing more of their range;
+        // once the cursor is on the emergency block that range is spent
+        if (current != NULL && current == arena->emergency) {
+            return NULL;
+        }
+        if (current == NULL) {
+            current = arena_block_reserve(arena, size);
+            if (current == NULL) {
+                return NULL;
+            }
+            arena->first = current;
+            arena->current = current;
+            arena->stats.blocks_created++;
+        }
+        size_t padding = arena_block_padding(current, alignment);
+        if (padding > current->reserved - current->size ||
+            size > current->reserved - current->size - padding ||
+            !arena_block_commit(current, current->size + padding + size)) {
+            if (arena->failure_policy == ARENA_FAIL_ABORT) {
+                arena_fatal("Reserved range of ", current->reserved, " bytes exhausted");
+            }
+            return NULL;
+        }
+        arena_stats_count(arena, size, padding + size);
+        return arena_block_bump(current, size, alignment);
+    }
+    
+    // Blocks after the cursor are empty ones kept by arena_reset or arena_rewind
+    void *data = NULL;
+    while (current != NULL && current->next != NULL) {
+        arena->used_before += current->size;
+        arena->stats.wasted_bytes += current->capacity - arena_block_used(current);
+        current = current->next;
+        data = arena_block_bump(current, size, alignment);
+        if (data != NULL) {
+            break;
+        }
+    }
+    
+    if (data == NULL) {
+        // Create a new block with room for the request; block data is
+        // already aligned to ARENA_ALIGNMENT
+        // On failure the cursor stays on the last block walked past, which
+        // used_before already accounts for
+        arena->current = current;
+        size_t needed = size + ((alignment > ARENA_ALIGNMENT) ? alignment - 1 : 0);
+        if (needed < size) {
+            return NULL;
+        }
+        ArenaBlock *block = arena_block_acquire(arena, arena_next_block_size(arena, needed), zeroed);
+        if (block == NULL) {
+            return NULL;
+        }
+        if (current == NULL) {
+            arena->first = block;
+            arena->used_before = 0;
+        } else {
+            current->next = block;
+            arena->used_before += current->size;
+            arena->stats.wasted_bytes += current->capacity - arena_block_used(current);
+        }
+        current = block;
+        data = arena_block_bump(current, size, alignment);
+    }
+    
+    // Blocks past the cursor are empty, so the whole of size went to this one
+    arena_stats_count(arena, size, current->size);
+    arena->current = current;
+    return data;
+}
+
+/**
+ * Serve an allocation from the emergency block, splicing it in after the
+ * cursor until the next arena_reset. The block has to hold the request; a
+ * smaller request can still have it afterwards.
+ * @param arena Pointer to the arena
+ * @param size Number of bytes to allocate
+ * @param alignment Alignment boundary (must be power of 2)
+ * @return Pointer to allocated memory, or NULL if there is no block that fits
+ */
+static void *arena_alloc_emergency(Arena *arena, size_t size, size_t alignment) {
+    ArenaBlock *block = arena->emergency;
+    if (block == NULL || arena->emergency_used) {
+        return NULL;
+    }
+    void *data = arena_block_bump(block, size, alignment);
+    if (data == NULL) {
+        return NULL;
+    }
+    
+    arena->emergency_used = true;
+    ArenaBlock *current = arena->current;
+    if (current == NULL) {
+        arena->first = block;
+        arena->used_before = 0;
+    } else {
+        block->next = current->next;
+        current->next = block;
+        arena->used_before += current->size;
+        arena->stats.wasted_bytes += current->capacity - arena_block_used(current);
+    }
+    arena_stats_count(arena, size, block->size);
+    arena->current = block;
+    return data;
+}
+
+/**
+ * Slow path of allocation: grow, and apply the failure policy if that
+ * fails.
+ * @param arena Pointer to the arena
+ * @param size Number of bytes to allocate
+ * @param alignment Alignment boundary (must be power of 2)
+ * @param zeroed Prefer zero-filled memory for a new block
+ * @return Pointer to allocated memory, or NULL as the policy says
+ */
+static void *arena_alloc_grow(Arena *arena, size_t size, size_t alignment, bool zeroed) {
+    void *data = arena_alloc_try_grow(arena, size, alignment, zeroed);
+    if (data != NULL) {
+        return data;
+    }
+    
+    switch (arena->failure_policy) {
+    case ARENA_FAIL_NULL:
+        return NULL;
+    case ARENA_FAIL_CALLBACK:
+        // Retried only once, so a handler that can't help doesn't loop
+        if (arena->on_failure != NULL && arena->on_failure(arena, size, arena->failure_context)) {
+            // A handler that reset or rewound the arena made room at the cursor
+            ArenaBlock *current = arena->current;
+            if (current != NULL) {
+                size_t before = current->size;
+                data = arena_block_bump(current, size, alignment);
+                if (data != NULL) {
+                    arena_stats_count(arena, size, current->size - before);
+                    return data;
+                }
+            }
+            return arena_alloc_try_grow(arena, size, alignment, zeroed);
+        }
+        return NULL;
+    case ARENA_FAIL_EMERGENCY:
+        return arena_alloc_emergency(arena, size, alignment);
+    default:
+        arena_fatal("Failed to allocate ", size, " bytes");
+        return NULL;
+    }
+}
+
+void *arena_alloc_slow(Arena *arena, size_t size, size_t alignment) {
+    return arena_alloc_grow(arena, size, alignment, false);
+}
+
+void *arena_alloc_zeroed(Arena *arena, size_t size) {
+    if (arena == NULL || size == 0) {
+        return NULL;
+    }
+    
+#ifdef ARENA_DEBUG
+    // Debug builds fill every allocation, so nothing is known to be zero
+    void *debug = arena_alloc_aligned(arena, size, ARENA_ALIGNMENT);
+    if (debug != NULL) {
+        memset(debug, 0, size);
+    }
+    return debug;
+#else
+    // Bytes up to the block's dirty mark or old size may have been used;
+    // everything past them is still zero from the OS or calloc
+    ArenaBlock *current = arena->current;
+    uint8_t *data = NULL;
+    size_t touched = 0;
+    if (current != NULL) {
+        size_t before = current->size;
+        touched = (current->dirty > before) ? current->dirty : before;
+        data = (uint8_t*)arena_block_bump(current, size, ARENA_ALIGNMENT);
+        if (data != NULL) {
+            arena_stats_count(arena, size, current->size - before);
+        }
+    }
+    if (data == NULL) {
+        data = (uint8_t*)arena_alloc_grow(arena, size, ARENA_ALIGNMENT, true);
+        if (data == NULL) {
+            return NULL;
+        }
+        if (arena->current != current) {
+            // Served by a block that was empty until now
+            touched = arena->current->dirty;
+        }
+    }
+    
+    size_t offset = (size_t)(data - arena->current->data);
+    if (touched > offset) {
+        memset(data, 0, (touched - offset < size) ? touched - offset : size);
+    }
+    ARENA_TRACE_EVENT(arena, ARENA_TRACE_ALLOC, size, 0, ARENA_ALIGNMENT);
+    return data;
+#endif
+}
+
+void *arena_calloc(Arena *arena, size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return NULL;
+    }
+    return arena_alloc_zeroed(arena, count * size);
+}
+
+void *arena_alloc_debug(Arena *arena, size_t size, size_t alignment) {
+    if (size > SIZE_MAX - ARENA_DEBUG_REDZONE) {
+        arena_fail(arena, size);
+        return NULL;
+    }
+    
+    // The redzone stays poisoned from when the block was created
+    size_t padded = size + ARENA_DEBUG_REDZONE;
+    ArenaBlock *current = arena->current;
+    void *data = NULL;
+    if (current != NULL) {
+        size_t before = current->size;
+        data = arena_block_bump(current, padded, alignment);
+        if (data != NULL) {
+            arena_stats_count(arena, size, current->size - before);
+        }
+    }
+    if (data == NULL) {
+        data = arena_alloc_slow(arena, padded, alignment);
+        if (data == NULL) {
+            return NULL;
+        }
+        arena->stats.bytes_requested -= ARENA_DEBUG_REDZONE;
+    }
+    arena_debug_fresh(data, size);
+    return data;
+}
+
+/**
+ * Index of the highest set bit.
+ * @param value Non-zero value
+ */
+static inline unsigned arena_log2(uint64_t value) {
+    return 63u - (unsigned)__builtin_clzll(value);
+}
+
+/**
+ * Take a released chunk that holds size bytes off the free lists.
+ * Only the request's own class k and the one above are searched: the
+ * request is over 2^(k-1) bytes and a chunk of class k+1 under 2^(k+2), so
+ * no chunk is handed out for an eighth of its size or less.
+ * @param arena Pointer to the arena
+ * @param size Number of bytes needed
+ * @return Pointer to the chunk, or NULL if none fits
+ */
+static void *arena_free_list_pop(Arena *arena, size_t size) {
+    if (size < sizeof(void*)) {
+        size = sizeof(void*);
+    }
+    unsigned size_class = arena_log2(size) + ((size & (size - 1)) != 0);
+    if (size_class >= ARENA_SIZE_CLASSES) {
+        return NULL;
+    }
+    
+    uint64_t candidates = (arena->free_mask >> size_class) & 3u;
+    if (candidates == 0) {
+        return NULL;
+    }
+    size_class += (unsigned)__builtin_ctzll(candidates);
+    
+    void *chunk = arena->free_lists[size_class];
+    ARENA_UNPOISON(chunk, sizeof(void*));
+    memcpy(&arena->free_lists[size_class], chunk, sizeof(void*));
+    if (arena->free_lists[size_class] == NULL) {
+        arena->free_mask &= ~((uint64_t)1 << size_class);
+    }
+    return chunk;
+}
+
+/**
+ * Drop every released chunk, e.g. when the memory behind them is reused.
+ * @param arena Pointer to the arena
+ */
+static inline void arena_free_list_clear(Arena *arena) {
+    if (arena->free_mask != 0) {
+        memset(arena->free_lists, 0, sizeof(void*) * ARENA_SIZE_CLASSES);
+        arena->free_mask = 0;
+    }
+}
+
+void *arena_alloc_recycled(Arena *arena, size_t size) {
+    void *chunk = arena_free_list_pop(arena, size);
+    if (chunk != NULL) {
+        arena_debug_fresh(chunk, size);
+        arena_stats_count(arena, size, 0);
+        ARENA_TRACE_EVENT(arena, ARENA_TRACE_ALLOC, size, 0, ARENA_ALIGNMENT);
+        return chunk;
+    }
+    return arena_alloc_aligned(arena, size, ARENA_ALIGNMENT);
+}
+
+void arena_release(Arena *arena, void *ptr, size_t size) {
+    if (arena == NULL || ptr == NULL || size == 0) {
+        return;
+    }
+    
+    // The top allocation (and its redzone) just moves the bump offset back
+    ArenaBlock *current = arena->current;
+    size_t top = size + ARENA_DEBUG_REDZONE;
+    arena_debug_dead(ptr, size);
+    if (current != NULL && top >= size && top <= current->size &&
+        (uint8_t*)ptr + top == &current->data[current->size]) {
+        arena_block_mark_dirty(current);
+        current->size -= top;
+        return;
+    }
+    
+    if (arena->free_lists == NULL || size < sizeof(void*) ||
+        (uintptr_t)ptr % ARENA_ALIGNMENT != 0) {
+        return;
+    }
+    
+    // Chunks sit in the class of their size rounded down, so every chunk of
+    // class k holds at least 2^k bytes
+    unsigned size_class = arena_log2(size);
+    ARENA_UNPOISON(ptr, sizeof(void*));
+    memcpy(ptr, &arena->free_lists[size_class], sizeof(void*));
+    ARENA_POISON(ptr, sizeof(void*));
+    arena->free_lists[size_class] = ptr;
+    arena->free_mask |= (uint64_t)1 << size_class;
+}
+
+bool arena_alloc_batch(Arena *arena, const size_t *sizes, size_t count, void **out) {
+    if (arena == NULL || (count != 0 && (sizes == NULL || out == NULL))) {
+        return false;
+    }
+    
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t size = arena_align_size(sizes[i], ARENA_ALIGNMENT);
+        if (size < sizes[i] || size > SIZE_MAX - total) {
+            return false;
+        }
+        total += size;
+    }
+    if (total == 0) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = NULL;
+        }
+        return true;
+    }
+    
+    uint8_t *data = (uint8_t*)arena_alloc_aligned(arena, total, ARENA_ALIGNMENT);
+    if (data == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        out[i] = sizes[i] ? data : NULL;
+        data += arena_align_size(sizes[i], ARENA_ALIGNMENT);
+    }
+    return true;
+}
+
+bool arena_alloc_batch_n(Arena *arena, size_t size, size_t count, void **out) {
+    if (arena == NULL || (count != 0 && out == NULL)) {
+        return false;
+    }
+    
+    size_t stride = arena_align_size(size, ARENA_ALIGNMENT);
+    if (stride < size || (stride != 0 && count > SIZE_MAX / stride)) {
+        return false;
+    }
+    if (stride == 0 || count == 0) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = NULL;
+        }
+        return true;
+    }
+    
+    uint8_t *data = (uint8_t*)arena_alloc_aligned(arena, stride * count, ARENA_ALIGNMENT);
+    if (data == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        out[i] = data + i * stride;
+    }
+    return true;
+}
+
+void *arena_reserve(Arena *arena, size_t size) {
+    if (arena == NULL) {
+        return NULL;
+    }
+    
+    // Only the committed part is traced, by arena_commit
+    ArenaTrace *trace = arena->trace;
+    arena->trace = NULL;
+    uint8_t *data = (uint8_t*)arena_alloc_aligned(arena, size, ARENA_ALIGNMENT);
+    arena->trace = trace;
+    if (data == NULL) {
+        return NULL;
+    }
+    
+    // Keep the alignment padding but hand the room itself back; the
+    // allocation is counted by arena_commit
+    arena_block_mark_dirty(arena->current);
+    arena->current->size = (size_t)(data - arena->current->data);
+    arena->stats.allocations--;
+    arena->stats.bytes_requested -= size;
+    arena->stats.bytes_allocated -= size + ARENA_DEBUG_REDZONE;
+    return data;
+}
+
+void *arena_commit(Arena *arena, size_t size) {
+    if (arena == NULL || arena->current == NULL) {
+        return NULL;
+    }
+    
+    // arena_reserve bumped room for the redzone too
+    ArenaBlock *current = arena->current;
+    assert(size + ARENA_DEBUG_REDZONE >= size &&
+           size + ARENA_DEBUG_REDZONE <= current->capacity - current->size);
+    uint8_t *data = &current->data[current->size];
+    current->size += size + ARENA_DEBUG_REDZONE;
+    ARENA_POISON(&data[size], current->capacity - (current->size - ARENA_DEBUG_REDZONE));
+    arena_stats_count(arena, size, size + ARENA_DEBUG_REDZONE);
+    ARENA_TRACE_EVENT(arena, ARENA_TRACE_ALLOC, size, 0, ARENA_ALIGNMENT);
+    return data;
+}
+
+void *arena_realloc(Arena *arena, void *old_ptr, size_t old_size, size_t new_size) {
+    if (arena == NULL) {
+        return NULL;
+    }
+    
+    if (new_size == 0) {
+        return NULL;
+    }
+    
+    if (old_ptr == NULL) {
+        return arena_alloc(arena, new_size);
+    }
+    
+    // The most recent allocation in the active block can be resized in
+    // place, its redzone moving along with its end
+    ArenaBlock *current = arena->current;
+    size_t old_top = old_size + ARENA_DEBUG_REDZONE;
+    size_t new_top = new_size + ARENA_DEBUG_REDZONE;
+    if (current != NULL && old_top >= old_size && new_top >= new_size && old_top <= current->size &&
+        (uint8_t*)old_ptr + old_top == &current->data[current->size]) {
+        size_t offset = current->size - old_top;
+        if (new_top <= current->capacity - offset ||
+            (current->reserved != 0 && new_top <= current->reserved - offset &&
+             arena_block_commit(current, offset + new_top))) {
+            arena_block_mark_dirty(current);
+            current->size = offset + new_top;
+            // The allocation itself changes size, so the byte counters follow
+            if (new_size > old_size) {
+                arena->stats.bytes_requested += new_size - old_size;
+                arena->stats.bytes_allocated += new_size - old_size;
+                arena_debug_fresh((uint8_t*)old_ptr + old_size, new_size - old_size);
+            } else {
+                size_t shrink = old_size - new_size;
+                arena->stats.bytes_requested -= (shrink < arena->stats.bytes_requested) ? shrink : arena->stats.bytes_requested;
+                arena->stats.bytes_allocated -= (shrink < arena->stats.bytes_allocated) ? shrink : arena->stats.bytes_allocated;
+                arena_debug_dead((uint8_t*)old_ptr + new_size, old_size - new_size);
+            }
+            ARENA_TRACE_EVENT(arena, ARENA_TRACE_REALLOC, new_size, old_size, ARENA_ALIGNMENT);
+            return old_ptr;
+        }
+    }
+    
+    if (new_size <= old_size) {
+        arena_debug_dead((uint8_t*)old_ptr + new_size, old_size - new_size);
+        ARENA_TRACE_EVENT(arena, ARENA_TRACE_REALLOC, new_size, old_size, ARENA_ALIGNMENT);
+        return old_ptr;
+    }
+
+    // The move is traced as one realloc, not as an allocation of its own
+    ArenaTrace *trace = arena->trace;
+    arena->trace = NULL;
+    void *new_ptr = arena_alloc(arena, new_size);
+    arena->trace = trace;
+    if (new_ptr == NULL) {
+        return NULL;
+    }
+    ARENA_TRACE_EVENT(arena, ARENA_TRACE_REALLOC, new_size, old_size, ARENA_ALIGNMENT);
+    
+    // Copy old data to new location
+    memcpy(new_ptr, old_ptr, old_size);
+    arena->stats.realloc_copies++;
+    arena->stats.bytes_copied += old_size;
+    
+    // The old buffer can only be reused by arenas with free lists
+    arena_release(arena, old_ptr, old_size);
+    return new_ptr;
+}
+
+ArenaConcurrent arena_concurrent_init(const ArenaConfig *config) {
+    ArenaConfig chained = {0};
+    if (config != NULL) {
+        chained = *config;
+    }
+    // Committing inside a reservation would race with the lock-free bump
+    chained.reserve_size = 0;
+    ArenaConcurrent arena = { arena_init_config(&chained) };
+    return arena;
+}
+
+/**
+ * Get a block for a concurrent arena, applying the failure policy when none
+ * can be acquired. The emergency block is claimed by whichever thread
+ * flips emergency_used first.
+ * @param arena Pointer to the arena
+ * @param capacity Capacity of the block to acquire
+ * @param size Size of the allocation that needs the block
+ * @return Block, or NULL as the policy says
+ */
+static ArenaBlock *arena_concurrent_block(Arena *arena, size_t capacity, size_t size) {
+    ArenaBlock *block = arena_block_acquire(arena, capacity, false);
+    if (block != NULL) {
+        return block;
+    }
+    
+    switch (arena->failure_policy) {
+    case ARENA_FAIL_NULL:
+        return NULL;
+    case ARENA_FAIL_CALLBACK:
+        if (arena->on_failure != NULL && arena->on_failure(arena, size, arena->failure_context)) {
+            return arena_block_acquire(arena, capacity, false);
+        }
+        return NULL;
+    case ARENA_FAIL_EMERGENCY:
+        block = arena->emergency;
+        if (block == NULL || block->capacity < size ||
+            __atomic_exchange_n(&arena->emergency_used, true, __ATOMIC_ACQ_REL)) {
+            return NULL;
+        }
+        return block;
+    default:
+        arena_fatal("Failed to allocate ", size, " bytes");
+        return NULL;
+    }
+}
+
+/**
+ * Give back a block that lost the race to be linked into the chain.
+ * @param arena Pointer to the arena
+ * @param block Block from arena_concurrent_block
+ */
+static void arena_concurrent_unused(Arena *arena, ArenaBlock *block) {
+    if (block == arena->emergency) {
+        __atomic_store_n(&arena->emergency_used, false, __ATOMIC_RELEASE);
+    } else {
+        arena_block_release(arena, block);
+    }
+}
+
+/**
+ * Install the first block of a concurrent arena whose initial block could
+ * not be created. Threads racing here agree on a single block.
+ * @param arena Pointer to the arena
+ * @param size Size of the allocation that needs the block
+ * @return First block, or NULL on failure
+ */
+static ArenaBlock *arena_concurrent_first(Arena *arena, size_t size) {
+    ArenaBlock *first = __atomic_load_n(&arena->first, __ATOMIC_ACQUIRE);
+    if (first == NULL) {
+        ArenaBlock *block = arena_concurrent_block(arena, arena->block_size, size);
+        if (block == NULL) {
+            return NULL;
+        }
+        if (__atomic_compare_exchange_n(&arena->first, &first, block, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+            first = block;
+        } else {
+            arena_concurrent_unused(arena, block);
+        }
+    }
+    
+    // The cursor follows; whoever sets it first sets it to the same block
+    ArenaBlock *current = NULL;
+    __atomic_compare_exchange_n(&arena->current, &current, first, false,
+                                __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    return first;
+}
+
+void *arena_concurrent_alloc(ArenaConcurrent *shared, size_t size) {
+    if (shared == NULL || size == 0) {
+        return NULL;
+    }
+    
+    Arena *arena = &shared->arena;
+    size_t requested = size;
+    size = arena_align_size(size, ARENA_ALIGNMENT) + ARENA_DEBUG_REDZONE;
+    if (size < requested) {
+        return NULL;
+    }
+    
+    if (__atomic_load_n(&arena->current, __ATOMIC_ACQUIRE) == NULL &&
+        arena_concurrent_first(arena, size) == NULL) {
+        return NULL;
+    }
+    
+    if (size > arena->max_block_size / 2) {
+        // Large requests take a whole block. Empty ones kept by a reset are
+        // claimed by moving their size from 0 straight to full, which fails
+        // if any thread bumped the block first
+        for (ArenaBlock *block = __atomic_load_n(&arena->first, __ATOMIC_ACQUIRE); block != NULL;
+             block = __atomic_load_n(&block->next, __ATOMIC_ACQUIRE)) {
+            size_t empty = 0;
+            if (block->capacity >= size &&
+                __atomic_compare_exchange_n(&block->size, &empty, block->capacity, false,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                arena_debug_fresh(block->data, requested);
+                return block->data;
+            }
+        }
+        
+        // Otherwise a dedicated, already full block is spliced in after the
+        // first one so it never races for space
+        ArenaBlock *block = arena_concurrent_block(arena, size, size);
+        if (block == NULL) {
+            return NULL;
+        }
+        block->size = block->capacity;
+        ArenaBlock *next = __atomic_load_n(&arena->first->next, __ATOMIC_ACQUIRE);
+        do {
+            block->next = next;
+        } while (!__atomic_compare_exchange_n(&arena->first->next, &next, block, true,
+                                              __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+        arena_debug_fresh(block->data, requested);
+        return block->data;
+    }
+    
+    for (;;) {
+        ArenaBlock *current = __atomic_load_n(&arena->current, __ATOMIC_ACQUIRE);
+        size_t offset = __atomic_fetch_add(&current->size, size, __ATOMIC_RELAXED);
+        if (offset + size <= current->capacity) {
+            arena_debug_fresh(&current->data[offset], requested);
+            return &current->data[offset];
+        }
+        
+        // Block exhausted: chain a new one unless another thread already did
+        ArenaBlock *next = __atomic_load_n(&current->next, __ATOMIC_ACQUIRE);
+        if (next == NULL) {
+            size_t capacity = arena_grow_size(arena, current->capacity);
+            ArenaBlock *block = arena_concurrent_block(arena, (capacity < size * 2) ? size * 2 : capacity, size);
+            if (block == NULL) {
+                return NULL;
+            }
+            if (__atomic_compare_exchange_n(&current->next, &next, block, false,
+                                            __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+                next = block;
+            } else {
+                arena_concurrent_unused(arena, block);
+            }
+        }
+        
+        // Losing this race just means someone else moved the cursor
+        __atomic_compare_exchange_n(&arena->current, &current, next, false,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
+}
+
+void arena_concurrent_reset(ArenaConcurrent *shared) {
+    if (shared == NULL) {
+        return;
+    }
+    arena_reset(&shared->arena);
+}
+
+void arena_concurrent_free(ArenaConcurrent *shared) {
+    if (shared == NULL) {
+        return;
+    }
+    arena_free(&shared->arena);
+}
+
+ArenaFrame arena_frame_init(const ArenaConfig *config) {
+    ArenaFrame frame = { { arena_init_config(config), arena_init_config(config) }, 0, 0 };
+    return frame;
+}
+
+void arena_frame_tick(ArenaFrame *frame) {
+    if (frame == NULL) {
+        return;
+    }
+    frame->current ^= 1;
+    frame->tick++;
+    arena_reset(&frame->arenas[frame->current]);
+}
+
+/**
+ * Check whether a pointer lies in the used part of one of an arena's blocks.
+ * @param arena Pointer to the arena
+ * @param ptr Pointer to look up
+ * @return true if the arena handed out ptr
+ */
+static bool arena_owns(const Arena *arena, const void *ptr) {
+    uintptr_t address = (uintptr_t)ptr;
+    for (const ArenaBlock *block = arena->first; block != NULL; block = block->next) {
+        uintptr_t start = (uintptr_t)block->data;
+        if (address >= start && address < start + block->size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void *arena_frame_promote(ArenaFrame *frame, const void *ptr, size_t size) {
+    if (frame == NULL || ptr == NULL) {
+        return NULL;
+    }
+    
+    Arena *current = arena_frame_current(frame);
+    if (arena_owns(current, ptr)) {
+        return (void*)ptr;
+    }
+    void *copy = arena_alloc(current, size);
+    if (copy != NULL) {
+        memcpy(copy, ptr, size);
+    }
+    return copy;
+}
+
+void arena_frame_free(ArenaFrame *frame) {
+    if (frame == NULL) {
+        return;
+    }
+    arena_free(&frame->arenas[0]);
+    arena_free(&frame->arenas[1]);
+}
+
+ArenaMark arena_mark(const Arena *arena) {
+    ArenaMark mark = { NULL, 0, 0 };
+    if (arena != NULL && arena->current != NULL) {
+        mark.block = arena->current;
+        mark.size = arena->current->size;
+        mark.used_before = arena->used_before;
+    }
+    return mark;
+}
+
+/**
+ * Fold the arena's current usage into its high-water mark.
+ * @param arena Pointer to the arena
+ */
+static inline void arena_update_high_water(Arena *arena) {
+    if (arena->current != NULL) {
+        size_t used = arena->used_before + arena_block_used(arena->current);
+        if (used > arena->high_water) {
+            arena->high_water = used;
+        }
+    }
+}
+
+void arena_rewind(Arena *arena, ArenaMark mark) {
+    if (arena == NULL) {
+        return;
+    }
+    
+    if (mark.block == NULL) {
+        arena_reset(arena);
+        return;
+    }
+    
+    arena_update_high_water(arena);
+    arena_free_list_clear(arena);
+    
+    // Blocks past the cursor are already empty, so only the span between
+    // the marker and the cursor needs clearing
+    ArenaBlock *current = mark.block->next;
+    while (current != NULL && current != arena->current->next) {
+        arena_debug_dead(current->data, arena_block_used(current));
+        arena_block_mark_dirty(current);
+        current->size = 0;
+        current = current->next;
+    }
+    if (mark.size < arena_block_used(mark.block)) {
+        arena_debug_dead(&mark.block->data[mark.size], arena_block_used(mark.block) - mark.size);
+    }
+    arena_block_mark_dirty(mark.block);
+    mark.block->size = mark.size;
+    arena->current = mark.block;
+    arena->used_before = mark.used_before;
+}
+
+/**
+ * Release every block after the first one whose capacity would take the
+ * chain past a budget. The first block is always kept.
+ * @param arena Pointer to the arena
+ * @param budget Total capacity to keep
+ */
+static void arena_trim_blocks(Arena *arena, size_t budget) {
+    ArenaBlock *keep = arena->first;
+    size_t total = keep->capacity;
+    while (keep->next != NULL && total + keep->next->capacity <= budget) {
+        keep = keep->next;
+        total += keep->capacity;
+    }
+    
+    ArenaBlock *current = keep->next;
+    while (current != NULL) {
+        ArenaBlock *next = current->next;
+        arena_block_release(arena, current);
+        current = next;
+    }
+    keep->next = NULL;
+}
+
+/**
+ * Replace a chain of blocks with a single block that fits a whole cycle.
+ * @param arena Pointer to the arena
+ * @param peak High-water mark of the cycle being reset
+ */
+static void arena_coalesce_blocks(Arena *arena, size_t peak) {
+    ArenaBlock *first = arena->first;
+    if (peak < arena->min_block_size) {
+        peak = arena->min_block_size;
+    }
+    
+    // A lone block is only replaced once it is far larger than needed
+    if (first->next == NULL && peak >= first->capacity / 4) {
+        return;
+    }
+    
+    ArenaBlock *current = first;
+    while (current != NULL) {
+        ArenaBlock *next = current->next;
+        arena_block_release(arena, current);
+        current = next;
+    }
+    arena->first = arena_block_acquire(arena, arena_align_size(peak, ARENA_ALIGNMENT), false);
+    if (arena->first == NULL) {
+        arena_fail(arena, peak);
+        return;
+    }
+    arena->block_size = arena->first->capacity;
+}
+
+/**
+ * Take the emergency block out of the chain if an allocation put it there.
+ * @param arena Pointer to the arena
+ */
+static void arena_emergency_unlink(Arena *arena) {
+    if (!arena->emergency_used) {
+        return;
+    }
+    ArenaBlock **link = &arena->first;
+    while (*link != arena->emergency) {
+        link = &(*link)->next;
+    }
+    *link = arena->emergency->next;
+    arena->emergency->next = NULL;
+    arena->emergency_used = false;
+}
+
+void arena_reset(Arena *arena) {
+    if (arena == NULL) {
+        return;
+    }
+    ARENA_TRACE_EVENT(arena, ARENA_TRACE_RESET, 0, 0, 1);
+    
+    if (arena->file != NULL && !arena->read_only) {
+        // Move readers of a shared arena to a new generation before any of
+        // the memory they may be reading is overwritten
+        __atomic_store_n(&arena->file->root, 0, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&arena->file->generation, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+    
+    arena_update_high_water(arena);
+    size_t peak = arena->high_water;
+    arena->high_water = 0;
+    if (peak > arena->stats.peak_used) {
+        arena->stats.peak_used = peak;
+    }
+    arena->used_before = 0;
+    arena_free_list_clear(arena);
+    
+    if (arena->emergency_used) {
+        // Take the emergency block back out of the chain for the next shortage
+        ArenaBlock *emergency = arena->emergency;
+        arena_emergency_unlink(arena);
+        arena_debug_dead(emergency->data, arena_block_used(emergency));
+        arena_block_mark_dirty(emergency);
+        emergency->size = 0;
+    }
+    
+    if (arena->first != NULL && arena->reserve_size == 0) {
+        switch (arena->reset_policy) {
+        case ARENA_RESET_COALESCE:
+            arena_coalesce_blocks(arena, peak);
+            break;
+        case ARENA_RESET_TRIM:
+            arena_trim_blocks(arena, arena->retain_size);
+            break;
+        default:
+            // Pooled arenas keep one block and hand the rest to other arenas
+            if (arena->pool != NULL) {
+                arena_trim_blocks(arena, 0);
+            }
+            break;
+        }
+    }
+    
+    ArenaBlock *current = arena->first;
+    while (current != NULL) {
+        arena_debug_dead(current->data, arena_block_used(current));
+        arena_block_mark_dirty(current);
+        current->size = 0;
+        current = current->next;
+    }
+    arena->current = arena->first;
+    
+    current = arena->first;
+    if (arena->reserve_size != 0 && arena->file == NULL && current != NULL) {
+        // Give committed memory beyond the retained amount back to the OS
+        size_t keep = arena_align_size(arena->retain_size, arena_commit_granularity());
+        if (keep < current->capacity) {
+            arena_os_decommit(&current->data[keep], current->capacity - keep);
+            current->capacity = keep;
+            
+            // Decommitted pages come back zero-filled
+            if (current->dirty > keep) {
+                current->dirty = keep;
+            }
+        }
+    }
+}
+
+void arena_free(Arena *arena) {
+    if (arena == NULL) {
+        return;
+    }
+    
+    if (arena->file != NULL) {
+        // The block's data is part of the file mapping, which goes as a whole
+        ArenaFileHeader *header = arena->file;
+        ARENA_UNPOISON(arena->first->data, (size_t)header->capacity);
+        arena_backing_free(&arena->allocator, arena->first, sizeof(ArenaBlock));
+        arena_os_unmap_file(header, sizeof(ArenaFileHeader) + (size_t)header->capacity);
+        arena->first = NULL;
+        arena->file = NULL;
+    }
+    if (arena->emergency != NULL) {
+        // It came from the arena's allocator even when it is pool-sized
+        arena_emergency_unlink(arena);
+        arena_block_delete(&arena->allocator, arena->emergency);
+    }
+    arena->emergency = NULL;
+    
+    ArenaBlock *current = arena->first;
+    while (current != NULL) {
+        ArenaBlock *next = current->next;
+        arena_block_release(arena, current);
+        current = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+    
+    if (arena->free_lists != NULL) {
+        arena_backing_free(&arena->allocator, arena->free_lists, sizeof(void*) * ARENA_SIZE_CLASSES);
+    }
+    arena->free_lists = NULL;
+    arena->free_mask = 0;
+}
+
+static void *arena_numa_alloc(void *context, size_t size) {
+    if (size < arena_os_page_size()) {
+        return malloc(size);
+    }
+    return arena_os_map_node(size, (int)(intptr_t)context);
+}
+
+static void *arena_numa_alloc_zeroed(void *context, size_t size) {
+    // Fresh mappings are zero-filled already
+    if (size < arena_os_page_size()) {
+        return calloc(1, size);
+    }
+    return arena_os_map_node(size, (int)(intptr_t)context);
+}
+
+static void arena_numa_free(void *context, void *ptr, size_t size) {
+    (void)context;
+    if (size < arena_os_page_size()) {
+        free(ptr);
+    } else {
+        arena_os_release(ptr, size);
+    }
+}
+
+ArenaAllocator arena_numa_allocator(int node) {
+    // The node travels in the context pointer, so the allocator needs no storage
+    ArenaAllocator allocator = {
+        arena_numa_alloc,
+        arena_numa_free,
+        (void*)(intptr_t)node,
+        arena_numa_alloc_zeroed,
+    };
+    return allocator;
+}
+
+int arena_numa_node_count(void) {
+    static int count;
+    if (count != 0) {
+        return count;
+    }
+    
+    int nodes = 1;
+#ifdef _WIN32
+    ULONG highest = 0;
+    if (GetNumaHighestNodeNumber(&highest)) {
+        nodes = (int)highest + 1;
+    }
+#elif defined(__linux__)
+    // Lists node ranges such as "0" or "0-3"; the last number is the highest node
+    FILE *file = fopen("/sys/devices/system/node/possible", "r");
+    if (file != NULL) {
+        int first = 0;
+        int last = 0;
+        int matched = fscanf(file, "%d-%d", &first, &last);
+        if (matched == 2) {
+            nodes = last + 1;
+        } else if (matched == 1) {
+            nodes = first + 1;
+        }
+        fclose(file);
+    }
+#endif
+    if (nodes < 1) {
+        nodes = 1;
+    } else if (nodes > ARENA_NUMA_MAX_NODES) {
+        nodes = ARENA_NUMA_MAX_NODES;
+    }
+    count = nodes;
+    return count;
+}
+
+int arena_numa_current_node(void) {
+#ifdef _WIN32
+    PROCESSOR_NUMBER processor;
+    USHORT node = 0;
+    GetCurrentProcessorNumberEx(&processor);
+    if (GetNumaProcessorNodeEx(&processor, &node)) {
+        return (int)node;
+    }
+#elif defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0) {
+        return (int)node;
+    }
+#endif
+    return 0;
+}
+
+ArenaNumaSet arena_numa_set_init(size_t block_size) {
+    ArenaNumaSet set;
+    set.node_count = arena_numa_node_count();
+    set.pools = (ArenaBlockPool*)ARENA_ALLOC(sizeof(ArenaBlockPool) * (size_t)set.node_count);
+    for (int node = 0; node < set.node_count; node++) {
+        set.pools[node] = arena_block_pool_init(block_size);
+        set.pools[node].allocator = arena_numa_allocator(node);
+    }
+    return set;
+}
+
+ArenaBlockPool *arena_numa_set_pool(ArenaNumaSet *set, int node) {
+    if (node == ARENA_NUMA_LOCAL) {
+        node = arena_numa_current_node();
+    }
+    if (node < 0 || node >= set->node_count) {
+        node = 0;
+    }
+    return &set->pools[node];
+}
+
+void arena_numa_set_free(ArenaNumaSet *set) {
+    if (set == NULL || set->pools == NULL) {
+        return;
+    }
+    
+    for (int node = 0; node < set->node_count; node++) {
+        arena_block_pool_free(&set->pools[node]);
+    }
+    ARENA_FREE(set->pools);
+    set->pools = NULL;
+    set->node_count = 0;
+}
+
+/** Calling thread's arena, handed out by arena_thread */
+static __thread Arena arena_thread_local;
+static __thread bool arena_thread_ready;
+
+Arena *arena_thread(ArenaBlockPool *pool) {
+    if (!arena_thread_ready) {
+        ArenaConfig config = { .pool = pool };
+        arena_thread_local = arena_init_config(&config);
+        arena_thread_ready = true;
+    }
+    return &arena_thread_local;
+}
+
+void arena_thread_release(void) {
+    if (!arena_thread_ready) {
+        return;
+    }
+    arena_free(&arena_thread_local);
+    arena_thread_ready = false;
+}
+
+ArenaStats arena_stats(const Arena *arena) {
+    ArenaStats stats = {0};
+    if (arena == NULL) {
+        return stats;
+    }
+    
+    stats = arena->stats;
+    for (const ArenaBlock *current = arena->first; current != NULL; current = current->next) {
+        stats.capacity += current->capacity;
+        stats.used += arena_block_used(current);
+        stats.block_count++;
+    }
+    
+    // The current cycle's peak is only folded in lazily
+    size_t peak = arena->high_water;
+    if (arena->current != NULL && arena->used_before + arena_block_used(arena->current) > peak) {
+        peak = arena->used_before + arena_block_used(arena->current);
+    }
+    if (peak > stats.peak_used) {
+        stats.peak_used = peak;
+    }
+    return stats;
+}
+
+/**
+ * Read a monotonic clock.
+ * @return Nanoseconds since an arbitrary starting point
+ */
+static uint64_t arena_trace_clock(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/** Magic bytes and version at the start of a trace file */
+static const char arena_trace_magic[8] = { 'A', 'R', 'E', 'N', 'A', 'T', 'R', 'C' };
+#define ARENA_TRACE_VERSION 1
+
+/**
+ * Header of a trace file; the events follow it.
+ */
+typedef struct ArenaTraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t event_size;
+    uint64_t count;
+} ArenaTraceHeader;
+
+ArenaTrace arena_trace_init(size_t capacity) {
+    if (capacity == 0) {
+        capacity = (size_t)1 << 16;
+    }
+    size_t rounded = 1;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    
+    ArenaTrace trace = {
+        .events = (ArenaTraceEvent*)ARENA_ALLOC(sizeof(ArenaTraceEvent) * rounded),
+        .capacity = rounded,
+        .head = 0,
+        .start = arena_trace_clock(),
+        .last_block = NULL,
+        .last_index = 0,
+    };
+    return trace;
+}
+
+void arena_trace_free(ArenaTrace *trace) {
+    if (trace == NULL) {
+        return;
+    }
+    ARENA_FREE(trace->events);
+    trace->events = NULL;
+    trace->capacity = 0;
+    trace->head = 0;
+}
+
+size_t arena_trace_count(const ArenaTrace *trace) {
+    if (trace == NULL) {
+        return 0;
+    }
+    return (trace->head < trace->capacity) ? (size_t)trace->head : trace->capacity;
+}
+
+const ArenaTraceEvent *arena_trace_event(const ArenaTrace *trace, size_t index) {
+    assert(index < arena_trace_count(trace));
+    uint64_t oldest = trace->head - arena_trace_count(trace);
+    return &trace->events[(oldest + index) & (trace->capacity - 1)];
+}
+
+void arena_trace_record(Arena *arena, ArenaTraceOp op, size_t size, size_t old_size, size_t alignment) {
+    ArenaTrace *trace = arena->trace;
+    
+    // The cursor only changes block on the slow path, so the chain is
+    // walked once per block rather than once per event
+    const ArenaBlock *block = arena->current;
+    if (block != trace->last_block) {
+        uint32_t index = 0;
+        for (const ArenaBlock *current = arena->first; current != NULL && current != block;
+             current = current->next) {
+            index++;
+        }
+        trace->last_block = block;
+        trace->last_index = index;
+    }
+    
+    ArenaTraceEvent *event = &trace->events[trace->head & (trace->capacity - 1)];
+    event->timestamp = arena_trace_clock() - trace->start;
+    event->size = size;
+    event->old_size = old_size;
+    event->block = trace->last_index;
+    event->op = (uint8_t)op;
+    event->align_log2 = (uint8_t)arena_log2(alignment);
+    event->unused = 0;
+    trace->head++;
+}
+
+bool arena_trace_save(const ArenaTrace *trace, const char *path) {
+    if (trace == NULL || path == NULL) {
+        return false;
+    }
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    
+    size_t count = arena_trace_count(trace);
+    ArenaTraceHeader header = { .version = ARENA_TRACE_VERSION,
+                                .event_size = sizeof(ArenaTraceEvent), .count = count };
+    memcpy(header.magic, arena_trace_magic, sizeof(header.magic));
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    
+    // The held events are at most two runs of the ring
+    size_t oldest = (size_t)((trace->head - count) & (trace->capacity - 1));
+    size_t first = (count < trace->capacity - oldest) ? count : trace->capacity - oldest;
+    ok = ok && fwrite(&trace->events[oldest], sizeof(ArenaTraceEvent), first, file) == first;
+    ok = ok && fwrite(trace->events, sizeof(ArenaTraceEvent), count - first, file) == count - first;
+    return (fclose(file) == 0) && ok;
+}
+
+/**
+ * Check that an event read from a file can be replayed.
+ * @param event Pointer to the event
+ * @return true if the op is known and the sizes and alignment are usable
+ */
+static bool arena_trace_event_valid(const ArenaTraceEvent *event) {
+    return event->op <= ARENA_TRACE_RESET && event->unused == 0 &&
+           event->align_log2 < sizeof(size_t) * 8 &&
+           ((size_t)1 << event->align_log2) <= ARENA_MAX_BLOCK_SIZE &&
+           event->size <= PTRDIFF_MAX && event->old_size <= PTRDIFF_MAX;
+}
+
+bool arena_trace_load(ArenaTrace *trace, const char *path) {
+    if (trace == NULL || path == NULL) {
+        return false;
+    }
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    
+    // The count comes from the file, so it must be backed by events in the
+    // file before it sizes an allocation
+    ArenaTraceHeader header;
+    long end = -1;
+    if (fread(&header, sizeof(header), 1, file) == 1 && fseek(file, 0, SEEK_END) == 0) {
+        end = ftell(file);
+    }
+    if (end < (long)sizeof(header) || fseek(file, (long)sizeof(header), SEEK_SET) != 0 ||
+        memcmp(header.magic, arena_trace_magic, sizeof(header.magic)) != 0 ||
+        header.version != ARENA_TRACE_VERSION || header.event_size != sizeof(ArenaTraceEvent) ||
+        header.count > ((uint64_t)end - sizeof(header)) / sizeof(ArenaTraceEvent)) {
+        fclose(file);
+        return false;
+    }
+    
+    *trace = arena_trace_init((size_t)header.count);
+    if (trace->events == NULL) {
+        fclose(file);
+        return false;
+    }
+    if (fread(trace->events, sizeof(ArenaTraceEvent), (size_t)header.count, file) != header.count) {
+        fclose(file);
+        arena_trace_free(trace);
+        return false;
+    }
+    for (uint64_t i = 0; i < header.count; i++) {
+        if (!arena_trace_event_valid(&trace->events[i])) {
+            fclose(file);
+            arena_trace_free(trace);
+            return false;
+        }
+    }
+    trace->head = header.count;
+    fclose(file);
+    return true;
+}
+
+void arena_trace_replay(const ArenaTrace *trace, Arena *arena) {
+    if (trace == NULL || arena == NULL) {
+        return;
+    }
+    
+    void *last = NULL;
+    size_t last_size = 0;
+    size_t count = arena_trace_count(trace);
+    for (size_t i = 0; i < count; i++) {
+        const ArenaTraceEvent *event = arena_trace_event(trace, i);
+        if (!arena_trace_event_valid(event)) {
+            continue;
+        }
+        size_t size = (size_t)event->size;
+        switch (event->op) {
+        case ARENA_TRACE_ALLOC:
+            // Default-aligned requests go through arena_alloc so the
+            // replaying arena's free lists take part
+            if (((size_t)1 << event->align_log2) == ARENA_ALIGNMENT) {
+                last = arena_alloc(arena, size);
+            } else {
+                last = arena_alloc_aligned(arena, size, (size_t)1 << event->align_log2);
+            }
+            last_size = size;
+            break;
+        case ARENA_TRACE_REALLOC:
+            if (last != NULL && last_size == event->old_size) {
+                last = arena_realloc(arena, last, last_size, size);
+            } else {
+                last = arena_alloc(arena, size);
+            }
+            last_size = size;
+            break;
+        case ARENA_TRACE_RESET:
+            arena_reset(arena);
+            last = NULL;
+            last_size = 0;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static const char arena_file_magic[8] = { 'A', 'R', 'E', 'N', 'A', 'I', 'M', 'G' };
+
+/**
+ * Build an arena over a mapped image: one block spanning the bytes after
+ * the header, never grown or decommitted.
+ * @param header Start of the mapping
+ * @param read_only Whether the mapping lacks write access
+ * @param dirty Bytes of the block that may be non-zero
+ * @return Arena over the image
+ */
+static Arena arena_file_arena(ArenaFileHeader *header, bool read_only, size_t dirty) {
+    size_t capacity = (size_t)header->capacity;
+    size_t used = (size_t)header->used;
+    Arena arena = {
+        .block_size = capacity,
+        .min_block_size = ARENA_INIT_SIZE,
+        .max_block_size = ARENA_MAX_BLOCK_SIZE,
+        .growth_factor = ARENA_GROWTH_FACTOR,
+        .retain_size = ARENA_COMMIT_SIZE,
+        .reserve_size = capacity,
+        .allocator = arena_default_allocator,
+        .file = header,
+        .read_only = read_only,
+    };
+    
+    ArenaBlock *block = (ArenaBlock*)arena_backing_alloc(&arena.allocator, sizeof(ArenaBlock));
+    block->next = NULL;
+    // Without room past the saved allocations a read-only arena can't bump
+    // into pages it may not write
+    block->capacity = read_only ? used : capacity;
+    block->size = used;
+    block->data = (uint8_t*)header + sizeof(ArenaFileHeader);
+    block->reserved = block->capacity;
+    block->dirty = dirty;
+    ARENA_POISON(&block->data[used], block->capacity - used);
+    
+    arena.first = block;
+    arena.current = block;
+    arena.stats.blocks_created = 1;
+    return arena;
+}
+
+/**
+ * Shared part of arena_create_file and arena_shared_create.
+ */
+static bool arena_file_create(Arena *arena, const char *path, size_t capacity, bool shared_memory) {
+    if (arena == NULL || path == NULL) {
+        return false;
+    }
+    
+    size_t size = arena_align_size(sizeof(ArenaFileHeader) + capacity, arena_os_page_size());
+    size_t length = 0;
+    ArenaFileHeader *header = (ArenaFileHeader*)arena_os_map_file(path, size, false, shared_memory, &length);
+    if (header == NULL) {
+        return false;
+    }
+    
+    // A new file reads as zeros, so only the header needs writing
+    memcpy(header->magic, arena_file_magic, sizeof(header->magic));
+    header->version = 1;
+    header->header_size = (uint32_t)sizeof(ArenaFileHeader);
+    header->capacity = length - sizeof(ArenaFileHeader);
+    *arena = arena_file_arena(header, false, 0);
+    return true;
+}
+
+/**
+ * Shared part of arena_open and arena_shared_open.
+ * @param read_only Don't allocate from the arena
+ * @param map_read_only Map without write access
+ */
+static bool arena_file_open(Arena *arena, const char *path, bool read_only,
+                            bool map_read_only, bool shared_memory) {
+    if (arena == NULL || path == NULL) {
+        return false;
+    }
+    
+    size_t length = 0;
+    ArenaFileHeader *header = (ArenaFileHeader*)arena_os_map_file(path, 0, map_read_only,
+                                                                  shared_memory, &length);
+    if (header == NULL) {
+        return false;
+    }
+    if (length < sizeof(ArenaFileHeader) ||
+        memcmp(header->magic, arena_file_magic, sizeof(header->magic)) != 0 ||
+        header->version != 1 ||
+        header->header_size != sizeof(ArenaFileHeader) ||
+        header->capacity != length - sizeof(ArenaFileHeader) ||
+        header->used > header->capacity) {
+        arena_os_unmap_file(header, length);
+        return false;
+    }
+    
+    // The root has to point at an allocation. A live segment's producer
+    // never saves, so there only the capacity bounds it
+    uint64_t root = __atomic_load_n(&header->root, __ATOMIC_ACQUIRE);
+    uint64_t end = sizeof(ArenaFileHeader) + (shared_memory ? header->capacity : header->used);
+    if (root != 0 && (root < sizeof(ArenaFileHeader) || root >= end || root % ARENA_ALIGNMENT != 0)) {
+        arena_os_unmap_file(header, length);
+        return false;
+    }
+    
+    // Whatever was allocated after the last save, or before a reset, is
+    // still in the file
+    *arena = arena_file_arena(header, read_only, (size_t)header->capacity);
+    return true;
+}
+
+bool arena_create_file(Arena *arena, const char *path, size_t capacity) {
+    return arena_file_create(arena, path, capacity, false);
+}
+
+bool arena_open(Arena *arena, const char *path, bool read_only) {
+    return arena_file_open(arena, path, read_only, read_only, false);
+}
+
+bool arena_save(Arena *arena) {
+    if (arena == NULL || arena->file == NULL || arena->read_only) {
+        return false;
+    }
+    
+    arena->file->used = arena->first->size;
+    return arena_os_sync_file(arena->file, sizeof(ArenaFileHeader) + arena->first->size);
+}
+
+void arena_set_root(Arena *arena, const void *ptr) {
+    if (arena == NULL || arena->file == NULL || arena->read_only) {
+        return;
+    }
+    assert((uintptr_t)ptr % ARENA_ALIGNMENT == 0);
+    __atomic_store_n(&arena->file->root, arena_offset(arena, ptr), __ATOMIC_RELEASE);
+}
+
+void *arena_root(const Arena *arena) {
+    if (arena == NULL || arena->file == NULL) {
+        return NULL;
+    }
+    return arena_pointer(arena, __atomic_load_n(&arena->file->root, __ATOMIC_ACQUIRE));
+}
+
+bool arena_shared_create(Arena *arena, const char *name, size_t capacity) {
+    return arena_file_create(arena, name, capacity, true);
+}
+
+bool arena_shared_open(Arena *arena, const char *name) {
+    return arena_file_open(arena, name, true, false, true);
+}
+
+bool arena_shared_unlink(const char *name) {
+#ifdef _WIN32
+    // A named mapping disappears with its last handle
+    (void)name;
+    return true;
+#else
+    return shm_unlink(name) == 0;
+#endif
+}
+
+uint64_t arena_shared_enter(Arena *arena) {
+    __atomic_fetch_add(&arena->file->readers, 1, __ATOMIC_ACQ_REL);
+    return __atomic_load_n(&arena->file->generation, __ATOMIC_ACQUIRE);
+}
+
+bool arena_shared_leave(Arena *arena, uint64_t generation) {
+    // Seqlock-style validation: the reads above happen before the recheck
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    bool intact = __atomic_load_n(&arena->file->generation, __ATOMIC_RELAXED) == generation;
+    __atomic_fetch_sub(&arena->file->readers, 1, __ATOMIC_RELEASE);
+    return intact;
+}
+
+bool arena_shared_reset(Arena *arena) {
+    if (arena == NULL || arena->file == NULL || arena->read_only ||
+        __atomic_load_n(&arena->file->readers, __ATOMIC_ACQUIRE) != 0) {
+        return false;
+    }
+    // A reader entering from here on either sees the new generation or
+    // finds its own gone stale in arena_shared_leave
+    arena_reset(arena);
+    return true;
+}
+
+void arena_print(const Arena *arena) {
+    if (arena == NULL) {
+        printf("Arena: NULL\n");
+        return;
+    }
+    
+    const ArenaBlock *current = arena->first;
+    int block_count = 0;
+    printf("Arena blocks: ");
+    while (current != NULL) {
+        printf("[%d: cap=%zu, used=%zu, ptr=%p] -> ", 
+               block_count++, current->capacity, arena_block_used(current), (void*)current->data);
+        current = current->next;
+    }
+    printf("NULL\n");
+    printf("Total blocks: %d, Total capacity: %zu, Total used: %zu\n", 
+           block_count, arena_total_capacity(arena), arena_total_used(arena));
+}
+
+size_t arena_total_capacity(const Arena *arena) {
+    if (arena == NULL) {
+        return 0;
+    }
+    
+    size_t total = 0;
+    const ArenaBlock *current = arena->first;
+    while (current != NULL) {
+        total += current->capacity;
+        current = current->next;
+    }
+    return total;
+}
+
+size_t arena_total_used(const Arena *arena) {
+    if (arena == NULL) {
+        return 0;
+    }
+    
+    size_t total = 0;
+    const ArenaBlock *current = arena->first;
+    while (current != NULL) {
+        total += arena_block_used(current);
+        current = current->next;
+    }
+    return total;
+}
+
+ArenaPool arena_pool_init(Arena *arena, size_t slot_size) {
+    if (slot_size < sizeof(void*)) {
+        slot_size = sizeof(void*);
+    }
+    
+    ArenaPool pool = {
+        .arena = arena,
+        .slot_size = arena_align_size(slot_size, ARENA_ALIGNMENT),
+        .free_list = NULL,
+    };
+    return pool;
+}
+
+void *arena_pool_alloc(ArenaPool *pool) {
+    if (pool == NULL) {
+        return NULL;
+    }
+    
+    void *slot = pool->free_list;
+    if (slot != NULL) {
+        ARENA_UNPOISON(slot, sizeof(void*));
+        memcpy(&pool->free_list, slot, sizeof(void*));
+        arena_debug_fresh(slot, pool->slot_size);
+        return slot;
+    }
+    return arena_alloc(pool->arena, pool->slot_size);
+}
+
+void arena_pool_free(ArenaPool *pool, void *ptr) {
+    if (pool == NULL || ptr == NULL) {
+        return;
+    }
+    
+    arena_debug_dead(ptr, pool->slot_size);
+    ARENA_UNPOISON(ptr, sizeof(void*));
+    memcpy(ptr, &pool->free_list, sizeof(void*));
+    ARENA_POISON(ptr, sizeof(void*));
+    pool->free_list = ptr;
+}
+
+void arena_pool_reset(ArenaPool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pool->free_list = NULL;
+}
+
+ArenaArray arena_array_init(Arena *arena, size_t item_size) {
+    ArenaArray array = {
+        .arena = arena,
+        .data = NULL,
+        .length = 0,
+        .capacity = 0,
+        .item_size = item_size,
+    };
+    return array;
+}
+
+bool arena_array_reserve(ArenaArray *array, size_t capacity) {
+    if (array == NULL || array->item_size == 0) {
+        return false;
+    }
+    if (capacity <= array->capacity) {
+        return true;
+    }
+    
+    // Grow geometrically so appends stay amortized O(1) when moving
+    size_t new_capacity = array->capacity ? array->capacity * 2 : 8;
+    if (new_capacity < capacity) {
+        new_capacity = capacity;
+    }
+    if (new_capacity > SIZE_MAX / array->item_size) {
+        return false;
+    }
+    
+    void *data = arena_realloc(array->arena, array->data,
+                               array->capacity * array->item_size,
+                               new_capacity * array->item_size);
+    if (data == NULL) {
+        return false;
+    }
+    array->data = data;
+    array->capacity = new_capacity;
+    return true;
+}
+
+void *arena_array_extend(ArenaArray *array, const void *items, size_t count) {
+    if (array == NULL || count > SIZE_MAX - array->length) {
+        return NULL;
+    }
+    if (!arena_array_reserve(array, array->length + count)) {
+        return NULL;
+    }
+    
+    uint8_t *slot = (uint8_t*)array->data + array->length * array->item_size;
+    if (items != NULL) {
+        memcpy(slot, items, count * array->item_size);
+    }
+    array->length += count;
+    return slot;
+}
+
+void *arena_array_push(ArenaArray *array, const void *item) {
+    return arena_array_extend(array, item, 1);
+}
+
+ArenaString arena_string_init(Arena *arena) {
+    ArenaString string = {
+        .arena = arena,
+        .data = NULL,
+        .length = 0,
+        .capacity = 0,
+    };
+    return string;
+}
+
+/**
+ * Make room for length more bytes plus the terminator.
+ * @param string Pointer to the string
+ * @param length Number of bytes about to be appended
+ * @return true on success, false on failure
+ */
+static bool arena_string_grow(ArenaString *string, size_t length) {
+    if (length > SIZE_MAX - string->length - 1) {
+        return false;
+    }
+    size_t needed = string->length + length + 1;
+    if (needed <= string->capacity) {
+        return true;
+    }
+    
+    size_t new_capacity = string->capacity ? string->capacity * 2 : 32;
+    if (new_capacity < needed) {
+        new_capacity = needed;
+    }
+    char *data = (char*)arena_realloc(string->arena, string->data, string->capacity, new_capacity);
+    if (data == NULL) {
+        return false;
+    }
+    string->data = data;
+    string->capacity = new_capacity;
+    return true;
+}
+
+bool arena_string_append_n(ArenaString *string, const char *text, size_t length) {
+    if (string == NULL || (text == NULL && length != 0)) {
+        return false;
+    }
+    if (!arena_string_grow(string, length)) {
+        return false;
+    }
+    
+    if (length != 0) {
+        memcpy(&string->data[string->length], text, length);
+    }
+    string->length += length;
+    string->data[string->length] = '\0';
+    return true;
+}
+
+bool arena_string_append(ArenaString *string, const char *text) {
+    if (text == NULL) {
+        return false;
+    }
+    return arena_string_append_n(string, text, strlen(text));
+}
+
+bool arena_string_vappendf(ArenaString *string, const char *format, va_list args) {
+    if (string == NULL || format == NULL) {
+        return false;
+    }
+    
+    // Try the spare capacity first; only grow and format again if it was too small
+    va_list retry;
+    va_copy(retry, args);
+    size_t spare = string->capacity ? string->capacity - string->length : 0;
+    int length = vsnprintf(spare ? &string->data[string->length] : NULL, spare, format, args);
+    if (length < 0) {
+        va_end(retry);
+        return false;
+    }
+    
+    if ((size_t)length >= spare) {
+        if (!arena_string_grow(string, (size_t)length)) {
+            va_end(retry);
+            return false;
+        }
+        vsnprintf(&string->data[string->length], (size_t)length + 1, format, retry);
+    }
+    va_end(retry);
+    string->length += (size_t)length;
+    return true;
+}
+
+bool arena_string_appendf(ArenaString *string, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    bool result = arena_string_vappendf(string, format, args);
+    va_end(args);
+    return result;
+}
+
+char *arena_string_slice(const ArenaString *string, size_t start, size_t length) {
+    if (string == NULL) {
+        return NULL;
+    }
+    if (start > string->length) {
+        start = string->length;
+    }
+    if (length > string->length - start) {
+        length = string->length - start;
+    }
+    
+    char *slice = (char*)arena_alloc_packed(string->arena, length + 1);
+    if (slice == NULL) {
+        return NULL;
+    }
+    if (length != 0) {
+        memcpy(slice, &string->data[start], length);
+    }
+    slice[length] = '\0';
+    return slice;
+}
+
+/**
+ * Scramble a 64-bit word (the splitmix64 finalizer).
+ */
+static inline uint64_t arena_hash_mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ull;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return value;
+}
+
+uint64_t arena_hash(const void *data, size_t length) {
+    // Consume a word at a time, so identifiers and header names hash in
+    // one or two rounds instead of a multiply per byte
+    const uint8_t *bytes = (const uint8_t*)data;
+    uint64_t hash = 0x9e3779b97f4a7c15ull ^ (uint64_t)length;
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, 8);
+        hash = arena_hash_mix(hash ^ word);
+        bytes += 8;
+        length -= 8;
+    }
+    if (length != 0) {
+        uint64_t word = 0;
+        memcpy(&word, bytes, length);
+        hash = arena_hash_mix(hash ^ word ^ ((uint64_t)length << 56));
+    }
+    return hash;
+}
+
+/**
+ * Hash a key for the map, reserving 0 for empty entries.
+ */
+static inline uint64_t arena_map_hash(const void *key, size_t key_length) {
+    uint64_t hash = arena_hash(key, key_length);
+    return hash ? hash : 1;
+}
+
+/**
+ * Distance of the entry in a slot from the slot its hash prefers.
+ */
+static inline size_t arena_map_distance(const ArenaMap *map, uint64_t hash, size_t slot) {
+    return (slot - (size_t)hash) & (map->capacity - 1);
+}
+
+/**
+ * Place an entry whose key is not in the map, displacing entries that are
+ * closer to their preferred slot than it is.
+ * @param map Pointer to the map, with at least one empty bucket
+ * @param entry Entry to place
+ * @return Pointer to where the entry ended up
+ */
+static ArenaMapEntry *arena_map_place(ArenaMap *map, ArenaMapEntry entry) {
+    size_t mask = map->capacity - 1;
+    size_t slot = (size_t)entry.hash & mask;
+    size_t distance = 0;
+    ArenaMapEntry *placed = NULL;
+    
+    for (;;) {
+        ArenaMapEntry *bucket = &map->entries[slot];
+        if (bucket->hash == 0) {
+            *bucket = entry;
+            return placed ? placed : bucket;
+        }
+        
+        size_t bucket_distance = arena_map_distance(map, bucket->hash, slot);
+        if (bucket_distance < distance) {
+            ArenaMapEntry displaced = *bucket;
+            *bucket = entry;
+            entry = displaced;
+            distance = bucket_distance;
+            if (placed == NULL) {
+                placed = bucket;
+            }
+        }
+        slot = (slot + 1) & mask;
+        distance++;
+    }
+}
+
+/**
+ * Rehash the map into a larger bucket array.
+ * @param map Pointer to the map
+ * @param capacity New number of buckets, a power of two
+ * @return true on success, false on failure
+ */
+static bool arena_map_grow(ArenaMap *map, size_t capacity) {
+    if (capacity > SIZE_MAX / sizeof(ArenaMapEntry)) {
+        return false;
+    }
+    ArenaMapEntry *entries = (ArenaMapEntry*)arena_alloc(map->arena, capacity * sizeof(ArenaMapEntry));
+    if (entries == NULL) {
+        return false;
+    }
+    memset(entries, 0, capacity * sizeof(ArenaMapEntry));
+    
+    // A map created with a capacity hint has no buckets yet
+    ArenaMapEntry *old_entries = map->entries;
+    size_t old_capacity = old_entries ? map->capacity : 0;
+    map->entries = entries;
+    map->capacity = capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_entries[i].hash != 0) {
+            arena_map_place(map, old_entries[i]);
+        }
+    }
+    arena_release(map->arena, old_entries, old_capacity * sizeof(ArenaMapEntry));
+    return true;
+}
+
+ArenaMap arena_map_init(Arena *arena, size_t capacity) {
+    // Buckets are sized so the hinted number of keys stays under 7/8 load
+    size_t buckets = 0;
+    if (capacity != 0) {
+        buckets = 8;
+        while (buckets - buckets / 8 < capacity) {
+            buckets *= 2;
+        }
+    }
+    
+    ArenaMap map = {
+        .arena = arena,
+        .entries = NULL,
+        .count = 0,
+        .capacity = buckets,
+    };
+    return map;
+}
+
+ArenaMapEntry *arena_map_find(const ArenaMap *map, const void *key, size_t key_length) {
+    if (map == NULL || map->count == 0) {
+        return NULL;
+    }
+    
+    uint64_t hash = arena_map_hash(key, key_length);
+    size_t mask = map->capacity - 1;
+    size_t slot = (size_t)hash & mask;
+    for (size_t distance = 0;; distance++) {
+        ArenaMapEntry *bucket = &map->entries[slot];
+        // Robin Hood order: a closer entry means the key would have been here
+        if (bucket->hash == 0 || arena_map_distance(map, bucket->hash, slot) < distance) {
+            return NULL;
+        }
+        if (bucket->hash == hash && bucket->key_length == key_length &&
+            memcmp(bucket->key, key, key_length) == 0) {
+            return bucket;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+/**
+ * Size of the arena chunk holding a key copy. With free lists it is a
+ * power of two, the only size a released chunk is found again at.
+ * @param map Pointer to the map
+ * @param key_length Number of key bytes
+ * @return Bytes to allocate and release for the copy
+ */
+static size_t arena_map_key_size(const ArenaMap *map, size_t key_length) {
+    size_t size = key_length + 1;
+    if (map->arena->free_lists == NULL || size > SIZE_MAX / 2) {
+        return size;
+    }
+    if (size < sizeof(void*)) {
+        return sizeof(void*);
+    }
+    return (size_t)1 << (arena_log2(size) + ((size & (size - 1)) != 0));
+}
+
+ArenaMapEntry *arena_map_insert(ArenaMap *map, const void *key, size_t key_length) {
+    if (map == NULL || (key == NULL && key_length != 0)) {
+        return NULL;
+    }
+    
+    ArenaMapEntry *entry = arena_map_find(map, key, key_length);
+    if (entry != NULL) {
+        return entry;
+    }
+    
+    if (map->entries == NULL || map->count + 1 > map->capacity - map->capacity / 8) {
+        size_t capacity = (map->entries == NULL && map->capacity != 0) ? map->capacity
+                        : (map->capacity ? map->capacity * 2 : 8);
+        if (!arena_map_grow(map, capacity)) {
+            return NULL;
+        }
+    }
+    
+    // Removed keys can only come back from the free lists when aligned
+    size_t key_size = arena_map_key_size(map, key_length);
+    char *copy = (char*)((map->arena->free_lists != NULL) ? arena_alloc(map->arena, key_size)
+                                                          : arena_alloc_packed(map->arena, key_size));
+    if (copy == NULL) {
+        return NULL;
+    }
+    if (key_length != 0) {
+        memcpy(copy, key, key_length);
+    }
+    copy[key_length] = '\0';
+    
+    ArenaMapEntry added = {
+        .key = copy,
+        .key_length = key_length,
+        .value = NULL,
+        .hash = arena_map_hash(key, key_length),
+    };
+    map->count++;
+    return arena_map_place(map, added);
+}
+
+void *arena_map_get(const ArenaMap *map, const void *key, size_t key_length) {
+    ArenaMapEntry *entry = arena_map_find(map, key, key_length);
+    return entry ? entry->value : NULL;
+}
+
+bool arena_map_put(ArenaMap *map, const void *key, size_t key_length, void *value) {
+    ArenaMapEntry *entry = arena_map_insert(map, key, key_length);
+    if (entry == NULL) {
+        return false;
+    }
+    entry->value = value;
+    return true;
+}
+
+bool arena_map_remove(ArenaMap *map, const void *key, size_t key_length) {
+    ArenaMapEntry *entry = arena_map_find(map, key, key_length);
+    if (entry == NULL) {
+        return false;
+    }
+    
+    void *copy = (void*)entry->key;
+    size_t key_size = arena_map_key_size(map, entry->key_length);
+    
+    // Backward-shift the following entries instead of leaving a tombstone
+    size_t mask = map->capacity - 1;
+    size_t slot = (size_t)(entry - map->entries);
+    size_t next = (slot + 1) & mask;
+    while (map->entries[next].hash != 0 &&
+           arena_map_distance(map, map->entries[next].hash, next) != 0) {
+        map->entries[slot] = map->entries[next];
+        slot = next;
+        next = (next + 1) & mask;
+    }
+    memset(&map->entries[slot], 0, sizeof(ArenaMapEntry));
+    map->count--;
+    arena_release(map->arena, copy, key_size);
+    return true;
+}
+
+ArenaIntern arena_intern_init(Arena *arena, size_t capacity) {
+    ArenaIntern table = { arena_map_init(arena, capacity) };
+    return table;
+}
+
+const char *arena_intern_n(ArenaIntern *table, const char *string, size_t length) {
+    if (table == NULL) {
+        return NULL;
+    }
+    ArenaMapEntry *entry = arena_map_insert(&table->map, string, length);
+    return entry ? entry->key : NULL;
+}
+
+const char *arena_intern(ArenaIntern *table, const char *string) {
+    if (string == NULL) {
+        return NULL;
+    }
+    return arena_intern_n(table, string, strlen(string));
+}
+
+const char *arena_intern_find(const ArenaIntern *table, const char *string, size_t length) {
+    if (table == NULL) {
+        return NULL;
+    }
+    ArenaMapEntry *entry = arena_map_find(&table->map, string, length);
+    return entry ? entry->key : NULL;
+}
+
+#endif // ARENA_IMPLEMENTATION_INCLUDED
+#endif // ARENA_IMPLEMENTATION
+
@@ -0,0 +1,226 @@
+/**
+ * Arena Allocator Library - C++ adaptors
+ *
+ * Lets standard containers allocate from an arena, either through
+ * std::pmr or through a classic allocator type, and ties arena marks to
+ * C++ scopes. Header-only on top of arena.h; link with arena.c as usual.
+ * Allocation goes through the inline arena_alloc and arena_alloc_aligned,
+ * so the bump fast path is inlined into the adaptors.
+ *
+ * Example:
+ *   arena::Arena arena(4096);
+ *   arena::Resource resource(arena);
+ *   std::pmr::vector<int> values(&resource);
+ *   {
+ *       arena::Scope scope(arena);  // Everything allocated here...
+ *       std::vector<int, arena::Allocator<int>> scratch(arena::Allocator<int>(arena));
+ *   }                               // ...is released here
+ *
+ * The arena never runs destructors and frees its memory in bulk, so
+ * containers must be destroyed (or simply abandoned, for trivially
+ * destructible contents) before the arena is reset, rewound or freed.
+ */
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include "arena.h"
+
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+namespace arena {
+
+/**
+ * Owning wrapper of an arena: initialized by the constructor, freed by
+ * the destructor. Converts to ::Arena* so it can be passed to the C API.
+ */
+class Arena {
+public:
+    /**
+     * Create an arena.
+     * @param capacity Initial capacity in bytes
+     */
+    explicit Arena(size_t capacity = ARENA_INIT_SIZE) : arena_(arena_init(capacity)) {}
+
+    /**
+     * Create an arena from a configuration.
+     * @param config Arena options
+     */
+    explicit Arena(const ArenaConfig &config) : arena_(arena_init_config(&config)) {}
+
+    ~Arena() { arena_free(&arena_); }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    ::Arena *get() noexcept { return &arena_; }
+    const ::Arena *get() const noexcept { return &arena_; }
+    operator ::Arena *() noexcept { return &arena_; }
+
+    /** Release every allocation, keeping the blocks (arena_reset). */
+    void reset() noexcept { arena_reset(&arena_); }
+
+private:
+    ::Arena arena_;
+};
+
+/**
+ * Allocate memory for a type or fail with std::bad_alloc.
+ * Up to ARENA_ALIGNMENT the request goes through arena_alloc, which reuses
+ * released chunks on arenas with free lists.
+ * @param arena Arena to allocate from
+ * @param size Number of bytes
+ * @param alignment Alignment boundary (must be power of 2)
+ * @return Pointer to allocated memory
+ */
+inline void *allocate(::Arena *arena, size_t size, size_t alignment) {
+    // The arena hands out nothing for 0 bytes, but operator new semantics
+    // want a unique pointer
+    size = size ? size : 1;
+    void *ptr = (alignment <= ARENA_ALIGNMENT) ? arena_alloc(arena, size)
+                                               : arena_alloc_aligned(arena, size, alignment);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+/**
+ * Construct an object in the arena. Its destructor never runs.
+ * @param arena Arena to allocate from
+ * @param args Constructor arguments
+ * @return Pointer to the new object
+ */
+template <class T, class... Args>
+T *create(::Arena *arena, Args &&...args) {
+    return new (allocate(arena, sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+}
+
+/**
+ * Construct an array of value-initialized objects in the arena.
+ * Their destructors never run.
+ * @param arena Arena to allocate from
+ * @param count Number of elements
+ * @return Pointer to the first element
+ */
+template <class T>
+T *create_array(::Arena *arena, size_t count) {
+    if (count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+        throw std::bad_alloc();
+    }
+    T *items = static_cast<T *>(allocate(arena, count * sizeof(T), alignof(T)));
+    for (size_t i = 0; i < count; i++) {
+        new (&items[i]) T();
+    }
+    return items;
+}
+
+/**
+ * An arena as a polymorphic memory resource for std::pmr containers.
+ * Deallocation goes to arena_release, so a container that grows its top
+ * allocation reuses the space, and arenas with free lists recycle the rest.
+ */
+class Resource : public std::pmr::memory_resource {
+public:
+    /**
+     * Wrap an arena, which must outlive the resource.
+     * @param arena Arena to allocate from
+     */
+    explicit Resource(::Arena *arena) noexcept : arena_(arena) {}
+
+    ::Arena *arena() const noexcept { return arena_; }
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        return arena::allocate(arena_, bytes, alignment);
+    }
+
+    void do_deallocate(void *ptr, size_t bytes, size_t alignment) override {
+        (void)alignment;
+        arena_release(arena_, ptr, bytes);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    ::Arena *arena_;
+};
+
+/**
+ * Allocator for standard containers that allocates from an arena.
+ * Copies and rebinds share the arena; two allocators compare equal when
+ * they use the same one.
+ */
+template <class T>
+class Allocator {
+public:
+    using value_type = T;
+
+    /**
+     * Bind to an arena, which must outlive every container using it.
+     * @param arena Arena to allocate from
+     */
+    Allocator(::Arena *arena) noexcept : arena_(arena) {}
+
+    template <class U>
+    Allocator(const Allocator<U> &other) noexcept : arena_(other.arena()) {}
+
+    ::Arena *arena() const noexcept { return arena_; }
+
+    T *allocate(size_t count) {
+        if (count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(arena::allocate(arena_, count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *ptr, size_t count) noexcept {
+        arena_release(arena_, ptr, count * sizeof(T));
+    }
+
+private:
+    ::Arena *arena_;
+};
+
+template <class T, class U>
+bool operator==(const Allocator<T> &a, const Allocator<U> &b) noexcept {
+    return a.arena() == b.arena();
+}
+
+template <class T, class U>
+bool operator!=(const Allocator<T> &a, const Allocator<U> &b) noexcept {
+    return a.arena() != b.arena();
+}
+
+/**
+ * Marks an arena on construction and rewinds it on destruction, releasing
+ * everything allocated during the scope. Objects allocated in the scope
+ * must not outlive it.
+ */
+class Scope {
+public:
+    /**
+     * Mark an arena.
+     * @param arena Arena to rewind when the scope ends
+     */
+    explicit Scope(::Arena *arena) noexcept : arena_(arena), mark_(arena_mark(arena)) {}
+
+    ~Scope() { arena_rewind(arena_, mark_); }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    ::Arena *arena_;
+    ArenaMark mark_;
+};
+
+} // namespace arena
+
+#endif // ARENA_HPP
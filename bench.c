@@ -0,0 +1,313 @@
+/**
+ * Microbenchmarks comparing the arena against malloc.
+ *
+ * Each benchmark runs in a forked child so its peak RSS can be read on its
+ * own. The malloc rows measure whichever malloc the process is linked
+ * with, so other allocators are compared by preloading them:
+ *   ./bench
+ *   LD_PRELOAD=/path/to/libjemalloc.so ./bench malloc
+ * An optional argument runs only the rows whose backend matches it.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "arena.h"
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#define BENCH_COUNT 1000000
+#define BENCH_THREADS 4
+#define BENCH_CYCLES 100
+#define BENCH_CYCLE_ALLOCS 10000
+
+/** Keeps the compiler from dropping allocations nobody reads */
+static volatile uintptr_t bench_sink;
+
+/** Sizes for the mixed benchmark, shared by every backend */
+static size_t bench_sizes[BENCH_COUNT];
+
+/** Pointers for the malloc backend, freed after each run */
+static void *bench_ptrs[BENCH_COUNT];
+
+typedef struct BenchResult {
+    double seconds;
+    size_t ops;
+} BenchResult;
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Fill bench_sizes with a fixed sequence of sizes between 8 and 1024.
+ */
+static void bench_init_sizes(void) {
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        bench_sizes[i] = 8 + (size_t)((state >> 33) % 1017);
+    }
+}
+
+static BenchResult bench_small_arena(void) {
+    double start = bench_now();
+    Arena arena = arena_init(0);
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        char *ptr = arena_alloc(&arena, 32);
+        ptr[0] = (char)i;
+        bench_sink += (uintptr_t)ptr;
+    }
+    arena_free(&arena);
+    return (BenchResult){ bench_now() - start, BENCH_COUNT };
+}
+
+static BenchResult bench_small_malloc(void) {
+    double start = bench_now();
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        char *ptr = malloc(32);
+        ptr[0] = (char)i;
+        bench_ptrs[i] = ptr;
+    }
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        free(bench_ptrs[i]);
+    }
+    return (BenchResult){ bench_now() - start, BENCH_COUNT };
+}
+
+static BenchResult bench_mixed_arena(void) {
+    double start = bench_now();
+    Arena arena = arena_init(0);
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        char *ptr = arena_alloc(&arena, bench_sizes[i]);
+        ptr[0] = (char)i;
+        bench_sink += (uintptr_t)ptr;
+    }
+    arena_free(&arena);
+    return (BenchResult){ bench_now() - start, BENCH_COUNT };
+}
+
+static BenchResult bench_mixed_malloc(void) {
+    double start = bench_now();
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        char *ptr = malloc(bench_sizes[i]);
+        ptr[0] = (char)i;
+        bench_ptrs[i] = ptr;
+    }
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        free(bench_ptrs[i]);
+    }
+    return (BenchResult){ bench_now() - start, BENCH_COUNT };
+}
+
+static BenchResult bench_append_arena(void) {
+    double start = bench_now();
+    Arena arena = arena_init(0);
+    char *buffer = NULL;
+    size_t length = 0;
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        buffer = arena_realloc(&arena, buffer, length, length + 16);
+        buffer[length] = (char)i;
+        length += 16;
+    }
+    bench_sink += (uintptr_t)buffer;
+    arena_free(&arena);
+    return (BenchResult){ bench_now() - start, BENCH_COUNT };
+}
+
+static BenchResult bench_append_malloc(void) {
+    double start = bench_now();
+    char *buffer = NULL;
+    size_t length = 0;
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        buffer = realloc(buffer, length + 16);
+        buffer[length] = (char)i;
+        length += 16;
+    }
+    bench_sink += (uintptr_t)buffer;
+    free(buffer);
+    return (BenchResult){ bench_now() - start, BENCH_COUNT };
+}
+
+static BenchResult bench_reset_arena(void) {
+    double start = bench_now();
+    Arena arena = arena_init(0);
+    for (size_t cycle = 0; cycle < BENCH_CYCLES; cycle++) {
+        for (size_t i = 0; i < BENCH_CYCLE_ALLOCS; i++) {
+            char *ptr = arena_alloc(&arena, bench_sizes[i]);
+            ptr[0] = (char)i;
+            bench_sink += (uintptr_t)ptr;
+        }
+        arena_reset(&arena);
+    }
+    arena_free(&arena);
+    return (BenchResult){ bench_now() - start, BENCH_CYCLES * BENCH_CYCLE_ALLOCS };
+}
+
+static BenchResult bench_reset_malloc(void) {
+    double start = bench_now();
+    for (size_t cycle = 0; cycle < BENCH_CYCLES; cycle++) {
+        for (size_t i = 0; i < BENCH_CYCLE_ALLOCS; i++) {
+            char *ptr = malloc(bench_sizes[i]);
+            ptr[0] = (char)i;
+            bench_ptrs[i] = ptr;
+        }
+        for (size_t i = 0; i < BENCH_CYCLE_ALLOCS; i++) {
+            free(bench_ptrs[i]);
+        }
+    }
+    return (BenchResult){ bench_now() - start, BENCH_CYCLES * BENCH_CYCLE_ALLOCS };
+}
+
+static ArenaBlockPool bench_pool;
+
+static void *bench_thread_arena(void *arg) {
+    (void)arg;
+    Arena *arena = arena_thread(&bench_pool);
+    for (size_t cycle = 0; cycle < BENCH_CYCLES; cycle++) {
+        for (size_t i = 0; i < BENCH_CYCLE_ALLOCS; i++) {
+            char *ptr = arena_alloc(arena, 32);
+            ptr[0] = (char)i;
+        }
+        arena_reset(arena);
+    }
+    arena_thread_release();
+    return NULL;
+}
+
+static void *bench_thread_malloc(void *arg) {
+    (void)arg;
+    void **ptrs = malloc(sizeof(void*) * BENCH_CYCLE_ALLOCS);
+    for (size_t cycle = 0; cycle < BENCH_CYCLES; cycle++) {
+        for (size_t i = 0; i < BENCH_CYCLE_ALLOCS; i++) {
+            char *ptr = malloc(32);
+            ptr[0] = (char)i;
+            ptrs[i] = ptr;
+        }
+        for (size_t i = 0; i < BENCH_CYCLE_ALLOCS; i++) {
+            free(ptrs[i]);
+        }
+    }
+    free(ptrs);
+    return NULL;
+}
+
+static BenchResult bench_threads(void *(*worker)(void*)) {
+    double start = bench_now();
+    pthread_t threads[BENCH_THREADS];
+    for (int t = 0; t < BENCH_THREADS; t++) {
+        pthread_create(&threads[t], NULL, worker, NULL);
+    }
+    for (int t = 0; t < BENCH_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    return (BenchResult){ bench_now() - start, (size_t)BENCH_THREADS * BENCH_CYCLES * BENCH_CYCLE_ALLOCS };
+}
+
+static BenchResult bench_threads_arena(void) {
+    bench_pool = arena_block_pool_init(0);
+    BenchResult result = bench_threads(bench_thread_arena);
+    arena_block_pool_free(&bench_pool);
+    return result;
+}
+
+static BenchResult bench_threads_malloc(void) {
+    return bench_threads(bench_thread_malloc);
+}
+
+typedef struct Bench {
+    const char *name;
+    const char *backend;
+    BenchResult (*run)(void);
+} Bench;
+
+static const Bench benches[] = {
+    { "small-fixed", "arena", bench_small_arena },
+    { "small-fixed", "malloc", bench_small_malloc },
+    { "mixed-sizes", "arena", bench_mixed_arena },
+    { "mixed-sizes", "malloc", bench_mixed_malloc },
+    { "realloc-append", "arena", bench_append_arena },
+    { "realloc-append", "malloc", bench_append_malloc },
+    { "reset-reuse", "arena", bench_reset_arena },
+    { "reset-reuse", "malloc", bench_reset_malloc },
+    { "threads", "arena", bench_threads_arena },
+    { "threads", "malloc", bench_threads_malloc },
+};
+
+/**
+ * Run one benchmark in a child process.
+ * @param bench Benchmark to run
+ * @param result Receives the child's timing
+ * @param max_rss_kb Receives the child's peak RSS in kilobytes
+ * @return true if the child ran to completion
+ */
+static bool bench_run_isolated(const Bench *bench, BenchResult *result, long *max_rss_kb) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        BenchResult child = bench->run();
+        ssize_t written = write(fds[1], &child, sizeof(child));
+        _exit(written == (ssize_t)sizeof(child) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t got = read(fds[0], result, sizeof(*result));
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid) {
+        return false;
+    }
+    *max_rss_kb = usage.ru_maxrss;
+    return got == (ssize_t)sizeof(*result) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char **argv) {
+    const char *filter = (argc > 1) ? argv[1] : NULL;
+    const char *preload = getenv("LD_PRELOAD");
+    bench_init_sizes();
+
+    printf("Arena Allocator Benchmarks\n");
+    if (preload != NULL && preload[0] != '\0') {
+        printf("malloc: %s\n", preload);
+    } else {
+        printf("malloc: system\n");
+    }
+    printf("%-16s %-8s %10s %12s %12s\n", "benchmark", "backend", "ns/op", "Mops/s", "max RSS KB");
+
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        const Bench *bench = &benches[i];
+        if (filter != NULL && strcmp(filter, bench->backend) != 0) {
+            continue;
+        }
+
+        BenchResult result;
+        long max_rss_kb = 0;
+        if (!bench_run_isolated(bench, &result, &max_rss_kb)) {
+            printf("%-16s %-8s failed\n", bench->name, bench->backend);
+            continue;
+        }
+        printf("%-16s %-8s %10.2f %12.2f %12ld\n", bench->name, bench->backend,
+               result.seconds * 1e9 / (double)result.ops,
+               (double)result.ops / result.seconds * 1e-6, max_rss_kb);
+    }
+    return 0;
+}
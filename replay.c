@@ -0,0 +1,93 @@
+/**
+ * Replay a captured allocation trace through several arena configurations
+ * and compare how each of them would have handled the workload.
+ *
+ * Capture a trace from a program built with -DARENA_TRACE:
+ *   ArenaTrace trace = arena_trace_init(0);
+ *   ArenaConfig config = { .trace = &trace };
+ *   ...
+ *   arena_trace_save(&trace, "arena.trace");
+ * then run:
+ *   ./replay arena.trace
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "arena.h"
+
+#include <time.h>
+
+typedef struct ReplayConfig {
+    const char *name;
+    ArenaConfig config;
+} ReplayConfig;
+
+static double replay_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <trace file>\n", argv[0]);
+        return 1;
+    }
+
+    ArenaTrace trace;
+    if (!arena_trace_load(&trace, argv[1])) {
+        fprintf(stderr, "Failed to load trace %s\n", argv[1]);
+        return 1;
+    }
+
+    size_t counts[3] = {0};
+    size_t blocks = 0;
+    for (size_t i = 0; i < arena_trace_count(&trace); i++) {
+        const ArenaTraceEvent *event = arena_trace_event(&trace, i);
+        if (event->op < 3) {
+            counts[event->op]++;
+        }
+        if (event->block + (size_t)1 > blocks) {
+            blocks = event->block + (size_t)1;
+        }
+    }
+    printf("Trace: %zu events (%zu allocs, %zu reallocs, %zu resets), %zu blocks when captured\n\n",
+           arena_trace_count(&trace), counts[ARENA_TRACE_ALLOC], counts[ARENA_TRACE_REALLOC],
+           counts[ARENA_TRACE_RESET], blocks);
+
+    ArenaBlockPool pool = arena_block_pool_init(0);
+    const ReplayConfig configs[] = {
+        { "default", { .capacity = 0 } },
+        { "init-4KB", { .capacity = 4096 } },
+        { "init-64KB", { .capacity = 65536 } },
+        { "growth-1.5", { .growth_factor = 1.5 } },
+        { "growth-4", { .growth_factor = 4.0 } },
+        { "fixed-64KB", { .capacity = 65536, .min_block_size = 65536, .max_block_size = 65536 } },
+        { "coalesce", { .reset_policy = ARENA_RESET_COALESCE } },
+        { "free-lists", { .free_lists = true } },
+        { "pooled", { .pool = &pool } },
+        { "virtual-1GB", { .reserve_size = (size_t)1 << 30 } },
+    };
+
+    printf("%-12s %8s %12s %12s %12s %10s %10s\n",
+           "config", "blocks", "capacity", "peak", "wasted", "copies", "ms");
+    for (size_t i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+        // A request the machine can't serve fails that event, not the replay
+        ArenaConfig config = configs[i].config;
+        config.failure_policy = ARENA_FAIL_NULL;
+        Arena arena = arena_init_config(&config);
+        double start = replay_now();
+        arena_trace_replay(&trace, &arena);
+        double elapsed = replay_now() - start;
+
+        ArenaStats stats = arena_stats(&arena);
+        printf("%-12s %8zu %12zu %12zu %12zu %10zu %10.3f\n", configs[i].name,
+               stats.blocks_created, stats.capacity, stats.peak_used,
+               stats.wasted_bytes, stats.realloc_copies, elapsed * 1e3);
+        arena_free(&arena);
+    }
+
+    arena_block_pool_free(&pool);
+    arena_trace_free(&trace);
+    return 0;
+}
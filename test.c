@@ -1,4 +1,23 @@
 #include "arena.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#ifdef ARENA_DEBUG
+#include <fcntl.h>
+#if defined(__SANITIZE_ADDRESS__)
+#define TEST_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define TEST_ASAN 1
+#endif
+#endif
+#ifdef TEST_ASAN
+#include <sanitizer/asan_interface.h>
+#endif
+#endif
 
 static void test_basic_allocation(void) {
     printf(" Testing Basic Allocation \n");
@@ -72,6 +91,82 @@ static void test_realloc(void) {
     printf("\n");
 }
 
+static void test_realloc_in_place(void) {
+    printf("=== Testing In-Place Reallocation ===\n");
+    Arena arena = arena_init(4096);
+    
+    // Appending to the top allocation never moves or leaks
+    char *buffer = arena_alloc(&arena, 16);
+    size_t length = 16;
+    for (int i = 0; i < 100; i++) {
+        char *grown = arena_realloc(&arena, buffer, length, length + 16);
+        assert(grown == buffer);
+        length += 16;
+    }
+    assert(arena_total_used(&arena) == length);
+    
+    // Shrinking the top allocation gives the tail back
+    buffer = arena_realloc(&arena, buffer, length, 100);
+    assert(arena_total_used(&arena) == 100);
+    
+    // Once something else is on top, growing has to copy
+    strcpy(buffer, "Moved");
+    arena_alloc(&arena, 8);
+    char *moved = arena_realloc(&arena, buffer, 100, 200);
+    assert(moved != buffer);
+    assert(strcmp(moved, "Moved") == 0);
+    
+    arena_print(&arena);
+    arena_free(&arena);
+    printf("\n");
+}
+
+static void test_free_lists(void) {
+    printf("=== Testing Size-Class Free Lists ===\n");
+    ArenaConfig config = { .capacity = 4096, .free_lists = true };
+    Arena arena = arena_init_config(&config);
+    
+    // A vector that keeps moving leaves dead buffers behind, which later
+    // allocations of the same size pick up
+    size_t size = 16;
+    char *vector = arena_alloc(&arena, size);
+    for (int i = 0; i < 6; i++) {
+        arena_alloc(&arena, 8);
+        char *old = vector;
+        vector = arena_realloc(&arena, vector, size, size * 2);
+        assert(arena_alloc(&arena, size) == old);
+        size *= 2;
+    }
+    size_t with_reuse = arena_total_used(&arena);
+    
+    // A released chunk is handed out again for a request of its class
+    char *chunk = arena_alloc(&arena, 100);
+    arena_alloc(&arena, 8);
+    arena_release(&arena, chunk, 100);
+    assert(arena_alloc(&arena, 64) == chunk);
+    
+    // Releasing the top allocation just rolls back the bump offset
+    size_t used = arena_total_used(&arena);
+    arena_release(&arena, arena_alloc(&arena, 64), 64);
+    assert(arena_total_used(&arena) == used);
+    arena_free(&arena);
+    
+    // Same workload without free lists
+    arena = arena_init(4096);
+    size = 16;
+    vector = arena_alloc(&arena, size);
+    for (int i = 0; i < 6; i++) {
+        arena_alloc(&arena, 8);
+        vector = arena_realloc(&arena, vector, size, size * 2);
+        arena_alloc(&arena, size);
+        size *= 2;
+    }
+    printf("Used with free lists: %zu, without: %zu\n", with_reuse, arena_total_used(&arena));
+    assert(with_reuse < arena_total_used(&arena));
+    arena_free(&arena);
+    printf("\n");
+}
+
 static void test_reset(void) {
     printf("=== Testing Arena Reset ===\n");
     Arena arena = arena_init(256);
@@ -96,6 +191,232 @@ static void test_reset(void) {
     printf("\n");
 }
 
+static void test_reset_policy(void) {
+    printf("=== Testing Reset Policies ===\n");
+    
+    // Coalesce: a spike collapses into one block that fits the next cycle
+    ArenaConfig coalesce = { .capacity = 256, .reset_policy = ARENA_RESET_COALESCE };
+    Arena arena = arena_init_config(&coalesce);
+    for (int i = 0; i < 100; i++) {
+        arena_alloc(&arena, 200);
+    }
+    assert(arena.first->next != NULL);
+    arena_reset(&arena);
+    assert(arena.first->next == NULL);
+    assert(arena.first->capacity >= 100 * 200);
+    for (int i = 0; i < 100; i++) {
+        arena_alloc(&arena, 200);
+    }
+    assert(arena.first->next == NULL);
+    
+    // Peaks hidden by a rewind still count
+    arena_reset(&arena);
+    ArenaMark mark = arena_mark(&arena);
+    for (int i = 0; i < 400; i++) {
+        arena_alloc(&arena, 200);
+    }
+    arena_rewind(&arena, mark);
+    arena_reset(&arena);
+    assert(arena.first->capacity >= 400 * 200);
+    
+    // A quiet cycle shrinks it back down
+    arena_alloc(&arena, 200);
+    arena_reset(&arena);
+    assert(arena.first->capacity < 400 * 200 / 4);
+    arena_free(&arena);
+    
+    // Trim: keep blocks up to the retained budget
+    ArenaConfig trim = {
+        .capacity = 1024,
+        .max_block_size = 1024,
+        .retain_size = 4096,
+        .reset_policy = ARENA_RESET_TRIM,
+    };
+    arena = arena_init_config(&trim);
+    for (int i = 0; i < 100; i++) {
+        arena_alloc(&arena, 1000);
+    }
+    arena_reset(&arena);
+    assert(arena_total_capacity(&arena) == 4096);
+    arena_print(&arena);
+    arena_free(&arena);
+    printf("\n");
+}
+
+typedef struct PoolNode {
+    struct PoolNode *left;
+    struct PoolNode *right;
+    int value;
+} PoolNode;
+
+static void test_object_pool(void) {
+    printf("=== Testing Object Pool ===\n");
+    Arena arena = arena_init(1024);
+    ArenaPool pool = ARENA_POOL(&arena, PoolNode);
+    
+    PoolNode *nodes[32];
+    for (int i = 0; i < 32; i++) {
+        nodes[i] = arena_pool_alloc(&pool);
+        nodes[i]->value = i;
+    }
+    size_t used = arena_total_used(&arena);
+    
+    // Churn reuses freed slots instead of growing the arena
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 32; i += 2) {
+            arena_pool_free(&pool, nodes[i]);
+        }
+        for (int i = 0; i < 32; i += 2) {
+            nodes[i] = arena_pool_alloc(&pool);
+            nodes[i]->value = i;
+        }
+    }
+    assert(arena_total_used(&arena) == used);
+    for (int i = 0; i < 32; i++) {
+        assert(nodes[i]->value == i);
+    }
+    printf("32 slots churned 100 times in %zu bytes\n", used);
+    
+    arena_reset(&arena);
+    arena_pool_reset(&pool);
+    assert(pool.free_list == NULL);
+    arena_free(&arena);
+    printf("\n");
+}
+
+static void test_array_and_string(void) {
+    printf("=== Testing Array and String Builder ===\n");
+    Arena arena = arena_init(1024);
+    
+    // The array is the top allocation, so it only moves when its block
+    // runs out
+    ArenaArray numbers = ARENA_ARRAY(&arena, int);
+    int moves = 0;
+    for (int i = 0; i < 1000; i++) {
+        void *data = numbers.data;
+        arena_array_push(&numbers, &i);
+        moves += (data != numbers.data);
+    }
+    int more[] = { 1000, 1001, 1002 };
+    arena_array_extend(&numbers, more, 3);
+    assert(numbers.length == 1003);
+    for (int i = 0; i < 1003; i++) {
+        assert(ARENA_ARRAY_AT(&numbers, int, i) == i);
+    }
+    assert(moves <= 3);
+    
+    // A string builder interleaved with other allocations still works
+    ArenaString line = arena_string_init(&arena);
+    arena_string_append(&line, "GET ");
+    arena_string_appendf(&line, "/items/%d?page=%s", 42, "next");
+    arena_alloc(&arena, 16);
+    for (int i = 0; i < 50; i++) {
+        arena_string_appendf(&line, "&k%d=%d", i, i * i);
+    }
+    assert(strncmp(line.data, "GET /items/42?page=next&k0=0&k1=1", 33) == 0);
+    assert(line.length == strlen(line.data));
+    
+    char *path = arena_string_slice(&line, 4, 9);
+    assert(strcmp(path, "/items/42") == 0);
+    printf("Built %zu byte string, slice: %s\n", line.length, path);
+    
+    arena_free(&arena);
+    printf("\n");
+}
+
+static void test_hash_map(void) {
+    printf("=== Testing Hash Map ===\n");
+    Arena arena = arena_init(4096);
+    ArenaMap map = arena_map_init(&arena, 0);
+    
+    char key[32];
+    for (int i = 0; i < 2000; i++) {
+        int length = snprintf(key, sizeof(key), "header-%d", i);
+        assert(arena_map_put(&map, key, (size_t)length, (void*)(uintptr_t)(i + 1)));
+    }
+    assert(map.count == 2000);
+    
+    for (int i = 0; i < 2000; i++) {
+        int length = snprintf(key, sizeof(key), "header-%d", i);
+        assert(arena_map_get(&map, key, (size_t)length) == (void*)(uintptr_t)(i + 1));
+    }
+    assert(arena_map_get(&map, "missing", 7) == NULL);
+    
+    // Replacing keeps the count; removing shifts later entries back
+    assert(arena_map_put(&map, "header-7", 8, (void*)(uintptr_t)99));
+    assert(map.count == 2000);
+    assert(arena_map_get(&map, "header-7", 8) == (void*)(uintptr_t)99);
+    for (int i = 0; i < 2000; i += 2) {
+        int length = snprintf(key, sizeof(key), "header-%d", i);
+        assert(arena_map_remove(&map, key, (size_t)length));
+    }
+    assert(map.count == 1000);
+    for (int i = 1; i < 2000; i += 2) {
+        int length = snprintf(key, sizeof(key), "header-%d", i);
+        void *expected = (void*)(uintptr_t)((i == 7) ? 99 : i + 1);
+        assert(arena_map_get(&map, key, (size_t)length) == expected);
+    }
+    assert(!arena_map_remove(&map, "header-0", 8));
+    printf("Map holds %zu keys in %zu buckets\n", map.count, map.capacity);
+    arena_free(&arena);
+    
+    // With free lists, removed keys make room for the ones inserted later
+    ArenaConfig config = { .free_lists = true };
+    arena = arena_init_config(&config);
+    map = arena_map_init(&arena, 256);
+    for (int i = 0; i < 100; i++) {
+        int length = snprintf(key, sizeof(key), "session-%d", i);
+        assert(arena_map_put(&map, key, (size_t)length, NULL));
+    }
+    size_t used = arena_total_used(&arena);
+    for (int i = 100; i < 10000; i++) {
+        int length = snprintf(key, sizeof(key), "session-%d", i - 100);
+        assert(arena_map_remove(&map, key, (size_t)length));
+        length = snprintf(key, sizeof(key), "session-%d", i);
+        assert(arena_map_put(&map, key, (size_t)length, NULL));
+    }
+    assert(map.count == 100 && arena_map_find(&map, "session-9999", 12) != NULL);
+    assert(arena_total_used(&arena) < used + 1024);
+    arena_free(&arena);
+    printf("\n");
+}
+
+static void test_intern(void) {
+    printf("=== Testing String Interning ===\n");
+    Arena arena = arena_init(4096);
+    ArenaIntern table = arena_intern_init(&arena, 64);
+    
+    const char *names[] = { "Host", "Content-Type", "Accept", "Host", "Accept", "Content-Length" };
+    const char *interned[6];
+    for (int i = 0; i < 6; i++) {
+        char copy[32];
+        strcpy(copy, names[i]);
+        interned[i] = arena_intern(&table, copy);
+        assert(strcmp(interned[i], names[i]) == 0);
+    }
+    
+    // Equal strings share one copy, so equality is a pointer compare
+    assert(interned[0] == interned[3]);
+    assert(interned[2] == interned[4]);
+    assert(interned[1] != interned[5]);
+    assert(table.map.count == 4);
+    
+    assert(arena_intern_find(&table, "Accept", 6) == interned[2]);
+    assert(arena_intern_find(&table, "Cookie", 6) == NULL);
+    assert(table.map.count == 4);
+    
+    // Interning the same string again costs no memory
+    size_t used = arena_total_used(&arena);
+    for (int i = 0; i < 100; i++) {
+        arena_intern(&table, "Content-Type");
+    }
+    assert(arena_total_used(&arena) == used);
+    printf("%zu distinct strings interned\n", table.map.count);
+    
+    arena_free(&arena);
+    printf("\n");
+}
+
 static void test_alignment(void) {
     printf("=== Testing Memory Alignment ===\n");
     Arena arena = arena_init(256);
@@ -141,14 +462,1269 @@ static void test_alignment(void) {
     printf("\n");
 }
 
+static void test_aligned_allocation(void) {
+    printf("=== Testing Aligned Allocation ===\n");
+    Arena arena = arena_init(256);
+    
+    // The pointer is aligned, not just the size
+    arena_alloc_packed(&arena, 3);
+    void *simd = arena_alloc_aligned(&arena, 100, 64);
+    assert((uintptr_t)simd % 64 == 0);
+    
+    // Packed allocations are contiguous
+    char *a = arena_alloc_packed(&arena, 5);
+    char *b = arena_alloc_packed(&arena, 3);
+    assert(b == a + 5);
+    
+    // Regular allocations still honour ARENA_ALIGNMENT after packed ones
+    void *c = arena_alloc(&arena, 8);
+    assert((uintptr_t)c % ARENA_ALIGNMENT == 0);
+    
+    // Alignment larger than the block's spare room moves to a new block
+    void *page = arena_alloc_aligned(&arena, 64, 4096);
+    assert((uintptr_t)page % 4096 == 0);
+    
+    arena_print(&arena);
+    arena_free(&arena);
+    printf("\n");
+}
+
+static void test_batch_allocation(void) {
+    printf("=== Testing Batch Allocation ===\n");
+    Arena arena = arena_init(256);
+    
+    // One capacity check for the whole batch: all chunks share a block
+    size_t sizes[] = { 24, 3, 100, 0, 17 };
+    void *ptrs[5];
+    assert(arena_alloc_batch(&arena, sizes, 5, ptrs));
+    assert(ptrs[3] == NULL);
+    for (int i = 0; i < 5; i++) {
+        if (ptrs[i] != NULL) {
+            assert((uintptr_t)ptrs[i] % ARENA_ALIGNMENT == 0);
+            memset(ptrs[i], 0xCC, sizes[i]);
+        }
+    }
+    assert((uint8_t*)ptrs[1] == (uint8_t*)ptrs[0] + 24);
+    assert((uint8_t*)ptrs[2] == (uint8_t*)ptrs[1] + 8);
+    
+    void *records[64];
+    assert(arena_alloc_batch_n(&arena, 12, 64, records));
+    for (int i = 1; i < 64; i++) {
+        assert((uint8_t*)records[i] == (uint8_t*)records[i - 1] + 16);
+    }
+    
+    // Reserve room for a message, decode into it, commit what was used
+    char *room = arena_reserve(&arena, 512);
+    size_t used = arena_total_used(&arena);
+    strcpy(room, "decoded");
+    char *message = arena_commit(&arena, 8);
+    assert(message == room);
+    assert(arena_total_used(&arena) == used + 8);
+    assert(strcmp(message, "decoded") == 0);
+    
+    arena_print(&arena);
+    arena_free(&arena);
+    printf("\n");
+}
+
+static void test_block_cursor(void) {
+    printf("=== Testing Block Cursor ===\n");
+    Arena arena = arena_init(ARENA_INIT_SIZE);
+    
+    // Fill several blocks; the cursor must always sit on the tail
+    for (int i = 0; i < 64; i++) {
+        void *ptr = arena_alloc(&arena, 100);
+        assert(ptr != NULL);
+        assert(arena.current->next == NULL);
+        assert((uint8_t*)ptr >= arena.current->data);
+        assert((uint8_t*)ptr < arena.current->data + arena.current->capacity);
+    }
+    
+    // After reset the cursor goes back to the first block and walks
+    // forward through the retained blocks instead of growing the chain
+    size_t capacity = arena_total_capacity(&arena);
+    arena_reset(&arena);
+    assert(arena.current == arena.first);
+    for (int i = 0; i < 64; i++) {
+        arena_alloc(&arena, 100);
+    }
+    assert(arena_total_capacity(&arena) == capacity);
+    printf("Capacity after reuse: %zu (unchanged)\n", capacity);
+    
+    arena_free(&arena);
+    assert(arena.first == NULL && arena.current == NULL);
+    printf("\n");
+}
+
+static void test_growth_policy(void) {
+    printf("=== Testing Growth Policy ===\n");
+    ArenaConfig config = {
+        .capacity = 256,
+        .min_block_size = 512,
+        .max_block_size = 4096,
+        .growth_factor = 2.0,
+    };
+    Arena arena = arena_init_config(&config);
+    
+    // Each full block forces the next one; sizes double from the minimum
+    // until they hit the cap
+    size_t expected[] = { 256, 512, 1024, 2048, 4096, 4096 };
+    for (size_t i = 1; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        arena_alloc(&arena, arena.current->capacity - arena.current->size + 8);
+        assert(arena.current->capacity == expected[i]);
+    }
+    
+    // Oversized requests get a dedicated block and leave the policy alone
+    arena_alloc(&arena, 10000);
+    assert(arena.current->capacity == 10000);
+    arena_alloc(&arena, 8);
+    assert(arena.current->capacity == 4096);
+    
+    arena_print(&arena);
+    arena_free(&arena);
+    printf("\n");
+}
+
+static void test_mark_rewind(void) {
+    printf("=== Testing Mark and Rewind ===\n");
+    Arena arena = arena_init(256);
+    
+    char *keep = arena_alloc(&arena, 32);
+    strcpy(keep, "Survives rewind");
+    
+    // Per-iteration temporaries never accumulate
+    size_t capacity = 0;
+    for (int i = 0; i < 100; i++) {
+        ArenaMark mark = arena_mark(&arena);
+        arena_alloc(&arena, 64);
+        arena_alloc(&arena, 1000);
+        arena_alloc(&arena, 64);
+        arena_rewind(&arena, mark);
+        assert(arena_total_used(&arena) == 32);
+        if (i == 0) {
+            capacity = arena_total_capacity(&arena);
+        }
+        assert(arena_total_capacity(&arena) == capacity);
+    }
+    assert(strcmp(keep, "Survives rewind") == 0);
+    
+    // Rewinding to the current position is a no-op
+    ArenaMark start = arena_mark(&arena);
+    arena_rewind(&arena, start);
+    assert(arena_total_used(&arena) == 32);
+    
+    arena_print(&arena);
+    arena_free(&arena);
+    printf("\n");
+}
+
+#define CONCURRENT_THREADS 8
+#define CONCURRENT_ALLOCS 10000
+
+typedef struct {
+    ArenaConcurrent *arena;
+    uint8_t id;
+    uint8_t *ptrs[CONCURRENT_ALLOCS];
+} ConcurrentWorker;
+
+static void *concurrent_worker(void *arg) {
+    ConcurrentWorker *worker = arg;
+    for (int i = 0; i < CONCURRENT_ALLOCS; i++) {
+        size_t size = 8 + (size_t)(i % 7) * 8;
+        worker->ptrs[i] = arena_concurrent_alloc(worker->arena, size);
+        memset(worker->ptrs[i], worker->id, size);
+    }
+    return NULL;
+}
+
+static void test_concurrent(void) {
+    printf("=== Testing Concurrent Arena ===\n");
+    ArenaConcurrent arena = arena_concurrent_init(NULL);
+    static ConcurrentWorker workers[CONCURRENT_THREADS];
+    pthread_t threads[CONCURRENT_THREADS];
+    
+    for (int t = 0; t < CONCURRENT_THREADS; t++) {
+        workers[t].arena = &arena;
+        workers[t].id = (uint8_t)(t + 1);
+        pthread_create(&threads[t], NULL, concurrent_worker, &workers[t]);
+    }
+    for (int t = 0; t < CONCURRENT_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    
+    // No allocation may have been handed out twice
+    size_t expected = 0;
+    for (int t = 0; t < CONCURRENT_THREADS; t++) {
+        for (int i = 0; i < CONCURRENT_ALLOCS; i++) {
+            size_t size = 8 + (size_t)(i % 7) * 8;
+            assert((uintptr_t)workers[t].ptrs[i] % ARENA_ALIGNMENT == 0);
+            for (size_t j = 0; j < size; j++) {
+                assert(workers[t].ptrs[i][j] == workers[t].id);
+            }
+            expected += size;
+        }
+    }
+    assert(arena_total_used(&arena.arena) >= expected);
+    printf("%d threads allocated %zu bytes, %zu used\n",
+           CONCURRENT_THREADS, expected, arena_total_used(&arena.arena));
+    
+    arena_concurrent_reset(&arena);
+    assert(arena_total_used(&arena.arena) == 0);
+    arena_concurrent_free(&arena);
+    
+    // Large requests reuse the blocks the previous cycle left empty
+    ArenaConfig large_config = { .max_block_size = 65536 };
+    arena = arena_concurrent_init(&large_config);
+    size_t capacity = 0;
+    for (int cycle = 0; cycle < 5; cycle++) {
+        for (int i = 0; i < 10; i++) {
+            memset(arena_concurrent_alloc(&arena, 40000), cycle, 40000);
+        }
+        ArenaStats stats = arena_stats(&arena.arena);
+        assert(cycle == 0 || stats.capacity == capacity);
+        capacity = stats.capacity;
+        arena_concurrent_reset(&arena);
+    }
+    assert(arena_stats(&arena.arena).block_count == 11);
+    arena_concurrent_free(&arena);
+    
+    // A virtual reservation can't grow safely under concurrent bumps, so
+    // the arena chains heap blocks instead
+    ArenaConfig config = { .capacity = 4096, .reserve_size = (size_t)1 << 20 };
+    arena = arena_concurrent_init(&config);
+    assert(arena.arena.reserve_size == 0 && arena.arena.first->reserved == 0);
+    for (int i = 0; i < 10; i++) {
+        memset(arena_concurrent_alloc(&arena, 1000), 0xCD, 1000);
+    }
+    assert(arena.arena.first->next != NULL);
+    arena_concurrent_free(&arena);
+    printf("\n");
+}
+
+static ArenaBlockPool pool_shared;
+
+static void *pool_worker(void *arg) {
+    (void)arg;
+    for (int job = 0; job < 100; job++) {
+        Arena *arena = arena_thread(&pool_shared);
+        for (int i = 0; i < 50; i++) {
+            memset(arena_alloc(arena, 1000), 0xAB, 1000);
+        }
+        arena_reset(arena);
+    }
+    arena_thread_release();
+    return NULL;
+}
+
+static void test_block_pool(void) {
+    printf("=== Testing Block Pool ===\n");
+    ArenaBlockPool pool = arena_block_pool_init(4096);
+    ArenaConfig config = { .pool = &pool };
+    
+    // Blocks freed by one arena are picked up by the next one
+    Arena first = arena_init_config(&config);
+    for (int i = 0; i < 20; i++) {
+        arena_alloc(&first, 1000);
+    }
+    size_t blocks = arena_total_capacity(&first) / pool.block_size;
+    arena_free(&first);
+    assert(arena_block_pool_count(&pool) == blocks);
+    
+    Arena second = arena_init_config(&config);
+    for (int i = 0; i < 20; i++) {
+        arena_alloc(&second, 1000);
+    }
+    assert(arena_block_pool_count(&pool) == 0);
+    
+    // Reset keeps one block and returns the rest
+    arena_reset(&second);
+    assert(arena_block_pool_count(&pool) == blocks - 1);
+    arena_free(&second);
+    arena_block_pool_free(&pool);
+    
+    // Thread-local arenas sharing one pool
+    pool_shared = arena_block_pool_init(4096);
+    pthread_t threads[4];
+    for (int t = 0; t < 4; t++) {
+        pthread_create(&threads[t], NULL, pool_worker, NULL);
+    }
+    for (int t = 0; t < 4; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    printf("Pool holds %zu blocks after 4 threads ran 100 jobs each\n",
+           arena_block_pool_count(&pool_shared));
+    arena_block_pool_free(&pool_shared);
+    printf("\n");
+}
+
+static void test_virtual_reserve(void) {
+    printf("=== Testing Virtual Reserve ===\n");
+    ArenaConfig config = {
+        .reserve_size = (size_t)1 << 30,
+        .retain_size = (size_t)1 << 20,
+    };
+    Arena arena = arena_init_config(&config);
+    
+    // The arena stays one contiguous block however much is allocated
+    uint8_t *base = arena_alloc(&arena, 1024);
+    uint8_t *last = base;
+    for (int i = 0; i < 16; i++) {
+        uint8_t *ptr = arena_alloc(&arena, (size_t)1 << 20);
+        assert(ptr == last + ((i == 0) ? 1024 : ((size_t)1 << 20)));
+        memset(ptr, i, (size_t)1 << 20);
+        last = ptr;
+    }
+    assert(arena.first->next == NULL);
+    
+    // The top allocation always grows in place
+    uint8_t *grown = arena_realloc(&arena, last, (size_t)1 << 20, (size_t)64 << 20);
+    assert(grown == last);
+    assert(grown[0] == 15);
+    printf("Committed after growth: %zu bytes\n", arena_total_capacity(&arena));
+    
+    // Reset gives everything above the retained amount back
+    arena_reset(&arena);
+    assert(arena_total_capacity(&arena) == config.retain_size);
+    assert(arena_alloc(&arena, 16) == base);
+    printf("Committed after reset: %zu bytes\n", arena_total_capacity(&arena));
+    
+    arena_free(&arena);
+    printf("\n");
+}
+
+static void test_huge_pages(void) {
+    printf("=== Testing Huge Pages ===\n");
+    ArenaConfig config = { .huge_pages = ARENA_HUGE_PAGES_2MB };
+    Arena arena = arena_init_config(&config);
+    
+    // Block sizes are rounded to the huge page size, and the mapping
+    // falls back to normal pages when huge pages are unavailable
+    size_t huge = (size_t)2 * 1024 * 1024;
+    char *small = arena_alloc(&arena, 64);
+    char *large = arena_alloc(&arena, 3 * huge);
+    memset(large, 0x5A, 3 * huge);
+    strcpy(small, "Huge");
+    
+    for (const ArenaBlock *block = arena.first; block != NULL; block = block->next) {
+        assert(block->capacity % huge == 0);
+    }
+    assert(arena.first->next != NULL);
+    assert(strcmp(small, "Huge") == 0);
+    printf("Blocks: first=%zu bytes, second=%zu bytes\n",
+           arena.first->capacity, arena.first->next->capacity);
+    
+    arena_free(&arena);
+    printf("\n");
+}
+
+static void test_stats(void) {
+    printf("=== Testing Statistics ===\n");
+    Arena arena = arena_init(1024);
+    ArenaStats stats = arena_stats(&arena);
+    assert(stats.allocations == 0 && stats.blocks_created == 1 && stats.block_count == 1);
+    
+    // Padding is counted separately from what was asked for
+    arena_alloc_packed(&arena, 3);
+    arena_alloc_aligned(&arena, 10, 64);
+    stats = arena_stats(&arena);
+    assert(stats.allocations == 2);
+    assert(stats.bytes_requested == 13);
+    assert(stats.bytes_allocated == stats.used);
+    assert(stats.bytes_allocated > stats.bytes_requested);
+    
+    // Moving past a block leaves its tail as waste
+    size_t used = stats.used;
+    arena_alloc(&arena, 2000);
+    stats = arena_stats(&arena);
+    assert(stats.blocks_created == 2 && stats.block_count == 2);
+    assert(stats.wasted_bytes == 1024 - used);
+    
+    // Only reallocations that move copy
+    char *buffer = arena_alloc(&arena, 100);
+    buffer = arena_realloc(&arena, buffer, 100, 200);
+    arena_alloc(&arena, 8);
+    arena_realloc(&arena, buffer, 200, 300);
+    stats = arena_stats(&arena);
+    assert(stats.realloc_copies == 1);
+    assert(stats.bytes_copied == 200);
+    
+    // The peak survives a reset
+    size_t peak = stats.used;
+    assert(stats.peak_used == peak);
+    arena_reset(&arena);
+    arena_alloc(&arena, 16);
+    stats = arena_stats(&arena);
+    assert(stats.used == 16);
+    assert(stats.peak_used == peak);
+    
+    // Resizing in place keeps the byte counters in step with usage
+    arena_reset(&arena);
+    size_t requested = arena.stats.bytes_requested;
+    size_t allocated = arena.stats.bytes_allocated;
+    char *text = arena_alloc(&arena, 16);
+    for (size_t size = 32; size <= 512; size += 16) {
+        assert(arena_realloc(&arena, text, size - 16, size) == text);
+    }
+    assert(arena_realloc(&arena, text, 512, 256) == text);
+    assert(arena.stats.bytes_requested - requested == 256);
+    assert(arena.stats.bytes_allocated - allocated == arena_total_used(&arena));
+    assert(arena.stats.realloc_copies == 1);
+    stats = arena_stats(&arena);
+    printf("%zu allocations, %zu requested, %zu allocated, %zu wasted, peak %zu\n",
+           stats.allocations, stats.bytes_requested, stats.bytes_allocated,
+           stats.wasted_bytes, stats.peak_used);
+    
+    arena_free(&arena);
+    printf("\n");
+}
+
+#ifdef ARENA_TRACE
+static void test_trace(void) {
+    printf("=== Testing Trace and Replay ===\n");
+    ArenaTrace trace = arena_trace_init(16);
+    ArenaConfig config = { .capacity = 256, .trace = &trace };
+    Arena arena = arena_init_config(&config);
+    
+    arena_alloc(&arena, 100);
+    arena_alloc_aligned(&arena, 32, 64);
+    char *buffer = arena_alloc(&arena, 64);
+    buffer = arena_realloc(&arena, buffer, 64, 128);
+    arena_alloc(&arena, 1000);
+    arena_reset(&arena);
+    
+    assert(arena_trace_count(&trace) == 6);
+    const ArenaTraceEvent *event = arena_trace_event(&trace, 1);
+    assert(event->op == ARENA_TRACE_ALLOC && event->size == 32 && event->align_log2 == 6);
+    event = arena_trace_event(&trace, 3);
+    assert(event->op == ARENA_TRACE_REALLOC && event->size == 128 && event->old_size == 64);
+    // The realloc outgrows the first block, the large allocation the second
+    assert(arena_trace_event(&trace, 0)->block == 0);
+    assert(arena_trace_event(&trace, 3)->block == 1);
+    assert(arena_trace_event(&trace, 4)->block == 2);
+    assert(arena_trace_event(&trace, 5)->op == ARENA_TRACE_RESET);
+    assert(arena_trace_event(&trace, 5)->timestamp >= arena_trace_event(&trace, 0)->timestamp);
+    
+    // The ring keeps the newest events once full
+    for (int i = 0; i < 20; i++) {
+        arena_alloc(&arena, (size_t)i + 1);
+    }
+    assert(arena_trace_count(&trace) == 16);
+    assert(arena_trace_event(&trace, 15)->size == 20);
+    assert(arena_trace_event(&trace, 0)->size == 5);
+    size_t traced = arena_stats(&arena).bytes_requested;
+    arena_free(&arena);
+    
+    // Save, load, and replay through another growth policy
+    const char *path = "/tmp/arena_test.trace";
+    assert(arena_trace_save(&trace, path));
+    ArenaTrace loaded;
+    assert(arena_trace_load(&loaded, path));
+    assert(arena_trace_count(&loaded) == 16);
+    assert(memcmp(arena_trace_event(&loaded, 3), arena_trace_event(&trace, 3), sizeof(ArenaTraceEvent)) == 0);
+    
+    // A count the file can't back is rejected before anything is allocated
+    const uint64_t counts[] = { 17, (uint64_t)1 << 40, UINT64_MAX };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        FILE *file = fopen(path, "r+b");
+        assert(file != NULL && fseek(file, 16, SEEK_SET) == 0);
+        assert(fwrite(&counts[i], sizeof(counts[i]), 1, file) == 1);
+        fclose(file);
+        ArenaTrace corrupt;
+        assert(!arena_trace_load(&corrupt, path));
+    }
+    
+    // So are events that can't be replayed: the count is restored, then
+    // the first event gets an unknown op, a huge alignment or a huge size
+    FILE *file = fopen(path, "r+b");
+    uint64_t count = 16;
+    assert(file != NULL && fseek(file, 16, SEEK_SET) == 0);
+    assert(fwrite(&count, sizeof(count), 1, file) == 1);
+    fclose(file);
+    ArenaTrace restored;
+    assert(arena_trace_load(&restored, path));
+    arena_trace_free(&restored);
+    ArenaTraceEvent original = *arena_trace_event(&loaded, 0);
+    for (int i = 0; i < 3; i++) {
+        ArenaTraceEvent event = original;
+        if (i == 0) {
+            event.op = 7;
+        } else if (i == 1) {
+            event.align_log2 = 200;
+        } else {
+            event.size = UINT64_MAX;
+        }
+        file = fopen(path, "r+b");
+        assert(file != NULL && fseek(file, 24, SEEK_SET) == 0);
+        assert(fwrite(&event, sizeof(event), 1, file) == 1);
+        fclose(file);
+        ArenaTrace corrupt;
+        assert(!arena_trace_load(&corrupt, path));
+    }
+    remove(path);
+    
+    ArenaConfig replay_config = { .capacity = 8, .growth_factor = 1.0 };
+    Arena replayed = arena_init_config(&replay_config);
+    arena_trace_replay(&loaded, &replayed);
+    ArenaStats stats = arena_stats(&replayed);
+    assert(stats.allocations == 16);
+    printf("Replayed %zu events into %zu blocks (traced arena requested %zu bytes)\n",
+           arena_trace_count(&loaded), stats.blocks_created, traced);
+    arena_free(&replayed);
+    arena_trace_free(&loaded);
+    arena_trace_free(&trace);
+    printf("\n");
+}
+#endif
+
+// Allocator that counts live allocations and bytes through its context,
+// and fails once more than limit bytes would be live (0 = no limit)
+typedef struct {
+    size_t allocs;
+    size_t frees;
+    size_t live_bytes;
+    size_t limit;
+} CountingAllocator;
+
+static void *counting_alloc(void *context, size_t size) {
+    CountingAllocator *counter = (CountingAllocator*)context;
+    if (counter->limit != 0 && counter->live_bytes + size > counter->limit) {
+        return NULL;
+    }
+    counter->allocs++;
+    counter->live_bytes += size;
+    return malloc(size);
+}
+
+static void counting_free(void *context, void *ptr, size_t size) {
+    CountingAllocator *counter = (CountingAllocator*)context;
+    counter->frees++;
+    counter->live_bytes -= size;
+    free(ptr);
+}
+
+static void *counting_alloc_zeroed(void *context, size_t size) {
+    CountingAllocator *counter = (CountingAllocator*)context;
+    counter->allocs++;
+    counter->live_bytes += size;
+    return calloc(1, size);
+}
+
+static bool all_zero(const unsigned char *ptr, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (ptr[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_calloc(void) {
+    printf("=== Testing Zeroed Allocation ===\n");
+    CountingAllocator zeroed = {0};
+    ArenaConfig config = {
+        .capacity = 4096,
+        .allocator = { counting_alloc, counting_free, &zeroed, counting_alloc_zeroed },
+    };
+    Arena arena = arena_init_config(&config);
+    
+    // Memory reused after a reset is cleared
+    unsigned char *dirty = arena_alloc(&arena, 1000);
+    memset(dirty, 0xAB, 1000);
+    arena_reset(&arena);
+    unsigned char *clean = arena_calloc(&arena, 250, 4);
+    assert(clean == dirty);
+    assert(all_zero(clean, 1000));
+    
+    // Past the old high-water mark only the reused part needs clearing
+    memset(clean, 0xAB, 1000);
+    arena_reset(&arena);
+    unsigned char *small = arena_alloc(&arena, 500);
+    unsigned char *straddle = arena_alloc_zeroed(&arena, 2000);
+    assert(all_zero(straddle, 2000));
+    (void)small;
+    
+#ifndef ARENA_DEBUG
+    // A block created for a zeroed allocation comes from alloc_zeroed
+    size_t allocs = zeroed.allocs;
+    unsigned char *large = arena_alloc_zeroed(&arena, (size_t)1 << 20);
+    assert(zeroed.allocs == allocs + 1);
+    assert(arena.current->dirty == 0);
+    assert(all_zero(large, (size_t)1 << 20));
+#endif
+    
+    assert(arena_calloc(&arena, SIZE_MAX / 2, 4) == NULL);
+    arena_free(&arena);
+    assert(zeroed.live_bytes == 0);
+    
+    // Rewinding keeps track of what was used, too
+    Arena rewound = arena_init(4096);
+    ArenaMark mark = arena_mark(&rewound);
+    memset(arena_alloc(&rewound, 100), 0xFF, 100);
+    arena_rewind(&rewound, mark);
+    assert(all_zero(arena_calloc(&rewound, 1, 100), 100));
+    arena_free(&rewound);
+    printf("Reused memory cleared, fresh blocks taken zero-filled\n");
+    printf("\n");
+}
+
+static void test_frame_arena(void) {
+    printf("=== Testing Frame Arenas ===\n");
+    ArenaFrame frame = arena_frame_init(NULL);
+    
+    // Memory from one tick survives the next, and promotion extends that
+    char *message = arena_frame_alloc(&frame, 32);
+    strcpy(message, "tick 0");
+    int *counter = arena_frame_alloc(&frame, sizeof(int));
+    *counter = 0;
+    assert(arena_frame_promote(&frame, counter, sizeof(int)) == counter);
+    arena_frame_tick(&frame);
+    assert(strcmp(message, "tick 0") == 0);
+    assert(arena_frame_previous(&frame) != arena_frame_current(&frame));
+    assert(arena_total_used(arena_frame_current(&frame)) == 0);
+    
+    size_t blocks = 0;
+    for (int tick = 1; tick <= 100; tick++) {
+        counter = arena_frame_promote(&frame, counter, sizeof(int));
+        (*counter)++;
+        for (int i = 0; i < 100; i++) {
+            memset(arena_frame_alloc(&frame, 64), tick, 64);
+        }
+        if (tick == 10) {
+            blocks = frame.arenas[0].stats.blocks_created + frame.arenas[1].stats.blocks_created;
+        }
+        arena_frame_tick(&frame);
+    }
+    assert(*counter == 100);
+    assert(frame.tick == 101);
+    
+    // Once both sides have grown to the working set, ticks reuse their blocks
+    assert(frame.arenas[0].stats.blocks_created + frame.arenas[1].stats.blocks_created == blocks);
+    assert(arena_frame_promote(&frame, NULL, 8) == NULL);
+    arena_frame_free(&frame);
+    printf("Counter promoted through 100 ticks on %zu blocks\n", blocks);
+    printf("\n");
+}
+
+static int failures_handled;
+
+static bool raise_limit(Arena *arena, size_t size, void *context) {
+    (void)arena;
+    CountingAllocator *counter = (CountingAllocator*)context;
+    failures_handled++;
+    if (size > (size_t)1 << 20) {
+        return false;
+    }
+    counter->limit += size * 2;
+    return true;
+}
+
+static bool reset_on_failure(Arena *arena, size_t size, void *context) {
+    (void)size;
+    (void)context;
+    failures_handled++;
+    arena_reset(arena);
+    return true;
+}
+
+static void exhaust_default_arena(void) {
+    CountingAllocator counter = { .limit = 8192 };
+    ArenaConfig config = {
+        .capacity = 4096,
+        .allocator = { counting_alloc, counting_free, &counter, NULL },
+    };
+    Arena arena = arena_init_config(&config);
+    arena_alloc(&arena, 65536);
+}
+
+static void test_failure_policy(void) {
+    printf("=== Testing Failure Policies ===\n");
+    CountingAllocator counter = { .limit = 8192 };
+    ArenaConfig config = {
+        .capacity = 4096,
+        .allocator = { counting_alloc, counting_free, &counter, NULL },
+        .failure_policy = ARENA_FAIL_NULL,
+    };
+    
+    // Failures come back as NULL and leave the arena usable
+    Arena arena = arena_init_config(&config);
+    assert(arena_alloc(&arena, 1000) != NULL);
+    size_t allocations = arena.stats.allocations;
+    assert(arena_alloc(&arena, 65536) == NULL);
+    assert(arena_calloc(&arena, 1, 65536) == NULL);
+    assert(arena_realloc(&arena, NULL, 0, 65536) == NULL);
+    assert(arena.stats.allocations == allocations);
+    assert(arena_alloc(&arena, 1000) != NULL);
+    arena_free(&arena);
+    assert(counter.live_bytes == 0);
+    
+    // Even the first block may fail; the arena starts empty and retries it
+    counter.limit = 100;
+    arena = arena_init_config(&config);
+    assert(arena.first == NULL && arena_alloc(&arena, 8) == NULL);
+    counter.limit = 65536;
+    assert(arena_alloc(&arena, 8) != NULL);
+    arena_free(&arena);
+    
+    // Or the free list table, which the arena then does without
+    counter.limit = 100;
+    config.free_lists = true;
+    arena = arena_init_config(&config);
+    assert(arena.first == NULL && arena.free_lists == NULL);
+    counter.limit = 65536;
+    char *chunk = arena_alloc(&arena, 64);
+    assert(chunk != NULL);
+    arena_alloc(&arena, 8);
+    arena_release(&arena, chunk, 64);
+    assert(arena_alloc(&arena, 64) != chunk);
+    arena_free(&arena);
+    assert(counter.live_bytes == 0);
+    config.free_lists = false;
+    
+    // So may the first block of a concurrent arena
+    counter.limit = 100;
+    ArenaConcurrent shared = arena_concurrent_init(&config);
+    assert(arena_concurrent_alloc(&shared, 8) == NULL);
+    assert(arena_concurrent_alloc(&shared, 65536) == NULL);
+    counter.limit = 65536;
+    assert(arena_concurrent_alloc(&shared, 8) != NULL);
+    assert(shared.arena.first != NULL && shared.arena.current == shared.arena.first);
+    arena_concurrent_free(&shared);
+    assert(counter.live_bytes == 0);
+    
+    // A callback can make room and have the allocation retried once
+    CountingAllocator handled = { .limit = 8192 };
+    config.allocator.context = &handled;
+    config.failure_policy = ARENA_FAIL_CALLBACK;
+    config.on_failure = raise_limit;
+    config.failure_context = &handled;
+    arena = arena_init_config(&config);
+    assert(arena_alloc(&arena, 65536) != NULL);
+    assert(failures_handled == 1);
+    assert(arena_alloc(&arena, (size_t)1 << 25) == NULL);
+    assert(failures_handled == 2);
+    arena_free(&arena);
+    
+    // A handler that resets the arena gets the retry served from its block
+    CountingAllocator single = { .limit = 5000 };
+    config.allocator.context = &single;
+    config.on_failure = reset_on_failure;
+    arena = arena_init_config(&config);
+    assert(arena_alloc(&arena, 3000) == arena.first->data);
+    assert(arena_alloc(&arena, 3000) == arena.first->data);
+    assert(failures_handled == 3 && arena.first->next == NULL);
+    arena_free(&arena);
+    assert(single.live_bytes == 0);
+    
+    // The emergency block rides out one shortage per reset
+    CountingAllocator reserve = { .limit = 4096 + 65536 + 1024 };
+    config.allocator.context = &reserve;
+    config.failure_policy = ARENA_FAIL_EMERGENCY;
+    config.emergency_size = 65536;
+    arena = arena_init_config(&config);
+    assert(arena.emergency != NULL && !arena.emergency_used);
+    char *rescued = arena_alloc(&arena, 20000);
+    assert(rescued != NULL && arena.emergency_used);
+    assert(arena.current == arena.emergency);
+    memset(rescued, 1, 20000);
+    assert(arena_alloc(&arena, 10000) != NULL);
+    assert(arena_alloc(&arena, 65536) == NULL);
+    arena_reset(&arena);
+    assert(!arena.emergency_used && arena.first->next == NULL);
+    assert(arena_alloc(&arena, 20000) == arena.emergency->data);
+    arena_free(&arena);
+    assert(reserve.live_bytes == 0);
+    
+    // Pooled arenas keep their emergency block out of the pool
+    CountingAllocator pooled = { .limit = 4096 + 1024 };
+    CountingAllocator own = {0};
+    ArenaBlockPool pool = arena_block_pool_init(4096);
+    pool.allocator = (ArenaAllocator){ counting_alloc, counting_free, &pooled, NULL };
+    config.allocator.context = &own;
+    config.pool = &pool;
+    config.emergency_size = 4096;
+    arena = arena_init_config(&config);
+    assert(pooled.allocs == 1 && own.allocs == 1);
+    assert(arena_alloc(&arena, 3000) != NULL);
+    assert(arena_alloc(&arena, 3000) == arena.emergency->data);
+    assert(arena_alloc(&arena, 3000) == NULL);
+    arena_reset(&arena);
+    assert(arena.first->next == NULL && !arena.emergency_used);
+    arena_free(&arena);
+    assert(own.live_bytes == 0 && pool.free != NULL && pool.free->next == NULL);
+    arena_block_pool_free(&pool);
+    assert(pooled.live_bytes == 0);
+    config.pool = NULL;
+    
+    // Virtual arenas fall back to it once their reservation is spent
+    ArenaConfig virtual_config = {
+        .reserve_size = (size_t)1 << 20,
+        .failure_policy = ARENA_FAIL_EMERGENCY,
+        .emergency_size = 65536,
+    };
+    arena = arena_init_config(&virtual_config);
+    assert(arena.emergency != NULL);
+    assert(arena_alloc(&arena, arena.first->reserved - ARENA_DEBUG_REDZONE) != NULL);
+    assert(arena_alloc(&arena, 1000) == arena.emergency->data);
+    assert(arena_alloc(&arena, 65536) == NULL);
+    arena_reset(&arena);
+    assert(arena.current == arena.first && arena.first->next == NULL);
+    assert(arena_alloc(&arena, 1000) == arena.first->data);
+    arena_free(&arena);
+    
+    // Concurrent arenas follow the same policies
+    CountingAllocator tight = { .limit = 8192 };
+    ArenaConfig concurrent_config = {
+        .capacity = 4096,
+        .allocator = { counting_alloc, counting_free, &tight, NULL },
+        .failure_policy = ARENA_FAIL_CALLBACK,
+        .on_failure = raise_limit,
+        .failure_context = &tight,
+    };
+    ArenaConcurrent concurrent = arena_concurrent_init(&concurrent_config);
+    int handled_before = failures_handled;
+    assert(arena_concurrent_alloc(&concurrent, 3000) != NULL);
+    assert(arena_concurrent_alloc(&concurrent, 3000) != NULL);
+    assert(failures_handled == handled_before + 1);
+    assert(arena_concurrent_alloc(&concurrent, (size_t)1 << 25) == NULL);
+    assert(failures_handled == handled_before + 2);
+    arena_concurrent_free(&concurrent);
+    assert(tight.live_bytes == 0);
+    
+    CountingAllocator spare = { .limit = 4096 + 65536 + 1024 };
+    concurrent_config.allocator.context = &spare;
+    concurrent_config.failure_policy = ARENA_FAIL_EMERGENCY;
+    concurrent_config.emergency_size = 65536;
+    concurrent = arena_concurrent_init(&concurrent_config);
+    assert(concurrent.arena.emergency != NULL);
+    assert(arena_concurrent_alloc(&concurrent, 3000) != NULL);
+    assert(arena_concurrent_alloc(&concurrent, 3000) == concurrent.arena.emergency->data);
+    assert(concurrent.arena.emergency_used);
+    assert(arena_concurrent_alloc(&concurrent, 100000) == NULL);
+    arena_concurrent_reset(&concurrent);
+    assert(!concurrent.arena.emergency_used && concurrent.arena.first->next == NULL);
+    arena_concurrent_free(&concurrent);
+    assert(spare.live_bytes == 0);
+    
+    // By default running out of memory still ends the process
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        freopen("/dev/null", "w", stderr);
+        exhaust_default_arena();
+        _exit(0);
+    }
+    int status = 0;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+    printf("NULL, callback and emergency policies degrade, the default aborts\n");
+    printf("\n");
+}
+
+static void test_backing_allocator(void) {
+    printf("=== Testing Backing Allocator ===\n");
+    CountingAllocator counter = {0};
+    ArenaConfig config = {
+        .capacity = 256,
+        .free_lists = true,
+        .allocator = { counting_alloc, counting_free, &counter, NULL },
+    };
+    
+    Arena arena = arena_init_config(&config);
+    for (int i = 0; i < 50; i++) {
+        arena_alloc(&arena, 100);
+    }
+    assert(counter.allocs > 0);
+    assert(counter.live_bytes >= arena_total_capacity(&arena));
+    arena_reset(&arena);
+    arena_alloc(&arena, 5000);
+    arena_free(&arena);
+    assert(counter.allocs == counter.frees);
+    assert(counter.live_bytes == 0);
+    
+    // Each chained block is a single allocation holding header and data
+    CountingAllocator block_counter = {0};
+    ArenaConfig chained = { .allocator = { counting_alloc, counting_free, &block_counter, NULL } };
+    Arena blocks = arena_init_config(&chained);
+    for (int i = 0; i < 100; i++) {
+        arena_alloc(&blocks, 200);
+    }
+    size_t block_count = 0;
+    for (const ArenaBlock *block = blocks.first; block != NULL; block = block->next) {
+        assert(block->data > (const uint8_t*)block);
+        assert(block->data - (const uint8_t*)block < 64);
+        block_count++;
+    }
+    assert(block_counter.allocs == block_count);
+    arena_free(&blocks);
+    assert(block_counter.frees == block_count);
+    
+    // Pooled blocks go back to the pool's allocator, not the arena's
+    CountingAllocator pool_counter = {0};
+    ArenaBlockPool pool = arena_block_pool_init(4096);
+    pool.allocator = (ArenaAllocator){ counting_alloc, counting_free, &pool_counter, NULL };
+    ArenaConfig pooled = { .pool = &pool };
+    Arena a = arena_init_config(&pooled);
+    for (int i = 0; i < 10; i++) {
+        arena_alloc(&a, 1000);
+    }
+    arena_alloc(&a, 10000);
+    arena_free(&a);
+    assert(pool_counter.allocs > 0);
+    assert(pool_counter.frees == 0);
+    arena_block_pool_free(&pool);
+    assert(pool_counter.allocs == pool_counter.frees);
+    assert(pool_counter.live_bytes == 0);
+    printf("Arena made %zu allocations, pool made %zu, all freed\n",
+           counter.allocs, pool_counter.allocs);
+    printf("\n");
+}
+
+static ArenaNumaSet numa_shared;
+
+static void *numa_worker(void *arg) {
+    (void)arg;
+    Arena *arena = arena_thread(arena_numa_set_pool(&numa_shared, ARENA_NUMA_LOCAL));
+    for (int i = 0; i < 100; i++) {
+        char *buffer = (char*)arena_alloc(arena, 1000);
+        memset(buffer, i, 1000);
+    }
+    arena_thread_release();
+    return NULL;
+}
+
+static void test_numa(void) {
+    printf("=== Testing NUMA Placement ===\n");
+    int nodes = arena_numa_node_count();
+    int node = arena_numa_current_node();
+    assert(nodes >= 1);
+    assert(node >= 0 && node < nodes);
+    
+    // Node-bound and first-touch arenas behave like any other arena
+    int targets[] = { node, ARENA_NUMA_LOCAL };
+    for (int t = 0; t < 2; t++) {
+        ArenaConfig config = { .capacity = 4096, .allocator = arena_numa_allocator(targets[t]) };
+        Arena arena = arena_init_config(&config);
+        for (int i = 0; i < 64; i++) {
+            char *buffer = (char*)arena_alloc(&arena, 1000);
+            memset(buffer, i, 1000);
+        }
+        assert(arena_total_used(&arena) == 64000);
+        arena_free(&arena);
+    }
+    
+    // Thread arenas drawn from the pool of the node each thread runs on
+    numa_shared = arena_numa_set_init(0);
+    assert(numa_shared.node_count == nodes);
+    assert(arena_numa_set_pool(&numa_shared, node) == &numa_shared.pools[node]);
+    pthread_t threads[4];
+    for (int t = 0; t < 4; t++) {
+        pthread_create(&threads[t], NULL, numa_worker, NULL);
+    }
+    for (int t = 0; t < 4; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    size_t pooled = 0;
+    for (int n = 0; n < numa_shared.node_count; n++) {
+        pooled += arena_block_pool_count(&numa_shared.pools[n]);
+    }
+    assert(pooled > 0);
+    printf("%d node(s), running on node %d, %zu blocks pooled\n", nodes, node, pooled);
+    arena_numa_set_free(&numa_shared);
+    printf("\n");
+}
+
+typedef struct FileNode {
+    ArenaOffset next;
+    int value;
+} FileNode;
+
+static void test_file_arena(void) {
+    printf("=== Testing File-Backed Arena ===\n");
+    const char *path = "/tmp/arena_test.img";
+    Arena arena;
+    assert(arena_create_file(&arena, path, 100000));
+    assert(arena.file != NULL && arena_total_capacity(&arena) >= 100000);
+    assert(arena_root(&arena) == NULL);
+    
+    // Build a list linked by offsets and record its head as the root
+    ArenaOffset head = 0;
+    for (int i = 0; i < 1000; i++) {
+        FileNode *node = arena_alloc(&arena, sizeof(FileNode));
+        node->next = head;
+        node->value = i;
+        head = arena_offset(&arena, node);
+    }
+    assert(arena_offset(&arena, NULL) == 0 && arena_pointer(&arena, 0) == NULL);
+    arena_set_root(&arena, arena_pointer(&arena, head));
+    size_t used = arena_total_used(&arena);
+    assert(arena_save(&arena));
+    arena_free(&arena);
+    assert(arena.file == NULL && arena.first == NULL);
+    
+    // The read-only image comes back wherever it's mapped, without copying
+    Arena image;
+    assert(arena_open(&image, path, true));
+    assert(image.read_only && arena_total_used(&image) == used);
+    assert(!arena_save(&image));
+    int expected = 999;
+    for (FileNode *node = arena_root(&image); node != NULL; node = arena_pointer(&image, node->next)) {
+        assert(node->value == expected--);
+    }
+    assert(expected == -1);
+    
+    // A second mapping of the same file can be open at the same time
+    Arena writer;
+    assert(arena_open(&writer, path, false));
+    assert(writer.file != image.file);
+    FileNode *first = arena_root(&writer);
+    FileNode *extra = arena_alloc(&writer, sizeof(FileNode));
+    extra->next = arena_offset(&writer, first);
+    extra->value = 1000;
+    arena_set_root(&writer, extra);
+    assert(arena_save(&writer));
+    assert(((FileNode*)arena_root(&image))->value == 1000);
+    arena_free(&image);
+    
+    // Reset forgets the allocations but not the file's old contents
+    arena_reset(&writer);
+    assert(arena_total_used(&writer) == 0);
+    assert(all_zero(arena_calloc(&writer, 1, 64), 64));
+    arena_free(&writer);
+    
+    // So are images whose root doesn't point at a saved allocation
+    assert(arena_open(&writer, path, false));
+    uint64_t used_end = sizeof(ArenaFileHeader) + writer.file->used;
+    arena_free(&writer);
+    const uint64_t roots[] = { 8, used_end, used_end + 4096, sizeof(ArenaFileHeader) + 1, UINT64_MAX };
+    FILE *file;
+    for (size_t i = 0; i <= sizeof(roots) / sizeof(roots[0]); i++) {
+        uint64_t root = (i < sizeof(roots) / sizeof(roots[0])) ? roots[i] : sizeof(ArenaFileHeader);
+        file = fopen(path, "r+b");
+        assert(file != NULL && fseek(file, offsetof(ArenaFileHeader, root), SEEK_SET) == 0);
+        assert(fwrite(&root, sizeof(root), 1, file) == 1);
+        fclose(file);
+        bool opened = arena_open(&image, path, true);
+        assert(opened == (root == sizeof(ArenaFileHeader)));
+        if (opened) {
+            assert(((FileNode*)arena_root(&image))->value == 0);
+            arena_free(&image);
+        }
+    }
+    
+    // Files that aren't images are rejected
+    file = fopen(path, "wb");
+    fputs("not an arena", file);
+    fclose(file);
+    assert(!arena_open(&image, path, true));
+    remove(path);
+    assert(!arena_open(&image, path, false));
+    printf("1000 offset-linked nodes saved and reopened in place\n");
+    printf("\n");
+}
+
+typedef struct SharedMessage {
+    ArenaOffset previous;
+    uint64_t sequence;
+    char text[32];
+} SharedMessage;
+
+/**
+ * Consumer side of test_shared_arena: read the published messages in place.
+ * @return Exit status for the child process, 0 if every message checks out
+ */
+static int shared_consumer(const char *name) {
+    Arena consumer;
+    if (!arena_shared_open(&consumer, name)) {
+        return 1;
+    }
+    uint64_t generation = arena_shared_enter(&consumer);
+    uint64_t expected = 100;
+    for (SharedMessage *message = arena_root(&consumer); message != NULL;
+         message = arena_pointer(&consumer, message->previous)) {
+        char text[32];
+        snprintf(text, sizeof(text), "message %llu", (unsigned long long)expected);
+        if (message->sequence != expected-- || strcmp(message->text, text) != 0) {
+            return 2;
+        }
+    }
+    bool intact = arena_shared_leave(&consumer, generation);
+    arena_free(&consumer);
+    return (intact && expected == 0) ? 0 : 3;
+}
+
+static void test_shared_arena(void) {
+    printf("=== Testing Shared-Memory Arena ===\n");
+    char name[64];
+    snprintf(name, sizeof(name), "/arena_test_%d", (int)getpid());
+    Arena producer;
+    assert(arena_shared_create(&producer, name, 65536));
+    
+    // Messages are built in the segment and published by the root store
+    for (uint64_t i = 1; i <= 100; i++) {
+        SharedMessage *message = arena_alloc(&producer, sizeof(SharedMessage));
+        message->previous = arena_offset(&producer, arena_root(&producer));
+        message->sequence = i;
+        snprintf(message->text, sizeof(message->text), "message %llu", (unsigned long long)i);
+        arena_set_root(&producer, message);
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        _exit(shared_consumer(name));
+    }
+    int status = 0;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    
+    // A reader inside holds off a coordinated reset
+    Arena consumer;
+    assert(arena_shared_open(&consumer, name));
+    assert(consumer.read_only);
+    uint64_t generation = arena_shared_enter(&consumer);
+    assert(((SharedMessage*)arena_root(&consumer))->sequence == 100);
+    assert(!arena_shared_reset(&producer));
+    assert(arena_shared_leave(&consumer, generation));
+    assert(arena_shared_reset(&producer));
+    assert(arena_total_used(&producer) == 0 && arena_root(&consumer) == NULL);
+    
+    // A reset behind a reader's back leaves its generation stale
+    generation = arena_shared_enter(&consumer);
+    arena_reset(&producer);
+    assert(!arena_shared_leave(&consumer, generation));
+    assert(consumer.file->readers == 0);
+    
+    arena_free(&consumer);
+    arena_free(&producer);
+    assert(arena_shared_unlink(name));
+    assert(!arena_shared_open(&consumer, name));
+    printf("100 messages read in place by another process\n");
+    printf("\n");
+}
+
+#ifdef ARENA_DEBUG
+/**
+ * Run a function in a child process.
+ * @return true if the child crashed or exited with an error
+ */
+static bool test_dies(void (*fn)(void *), void *arg) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Keep the sanitizer report of the expected crash out of the output
+        int null_fd = open("/dev/null", O_WRONLY);
+        if (null_fd >= 0) {
+            dup2(null_fd, 2);
+        }
+        fn(arg);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
+
+static void overflow_by_one(void *arg) {
+    char *ptr = (char*)arg;
+    ptr[10] = 1;
+}
+
+static void use_after_reset(void *arg) {
+    Arena *arena = (Arena*)arg;
+    char *ptr = arena_alloc(arena, 16);
+    arena_reset(arena);
+    ptr[0] = 1;
+}
+
+static void test_debug_mode(void) {
+    printf("=== Testing Debug Mode ===\n");
+    Arena arena = arena_init(1024);
+    
+    // Allocations are filled, and each is followed by a redzone
+    unsigned char *a = arena_alloc(&arena, 10);
+    unsigned char *b = arena_alloc(&arena, 10);
+    for (int i = 0; i < 10; i++) {
+        assert(a[i] == ARENA_DEBUG_ALLOC_BYTE);
+    }
+    assert(b >= a + 10 + ARENA_DEBUG_REDZONE);
+    
+    // In-place reallocation and top release still work with redzones
+    unsigned char *grown = arena_realloc(&arena, b, 10, 40);
+    assert(grown == b);
+    assert(grown[39] == ARENA_DEBUG_ALLOC_BYTE);
+    size_t used = arena_total_used(&arena);
+    arena_release(&arena, grown, 40);
+    assert(arena_total_used(&arena) == used - 40 - ARENA_DEBUG_REDZONE);
+    
+#ifdef TEST_ASAN
+    assert(!__asan_address_is_poisoned(a + 9));
+    assert(__asan_address_is_poisoned(a + 10));
+    assert(__asan_address_is_poisoned(a + 10 + ARENA_DEBUG_REDZONE - 1));
+    assert(test_dies(overflow_by_one, a));
+    assert(test_dies(use_after_reset, &arena));
+    arena_reset(&arena);
+    assert(__asan_region_is_poisoned(a, 10) != NULL);
+    printf("Overflow and use after reset caught by AddressSanitizer\n");
+#else
+    // Without ASan the released memory is only filled
+    arena_reset(&arena);
+    assert(a[0] == ARENA_DEBUG_FREE_BYTE);
+    (void)test_dies;
+    (void)overflow_by_one;
+    (void)use_after_reset;
+    printf("Released memory filled with 0x%02X\n", ARENA_DEBUG_FREE_BYTE);
+#endif
+    
+    arena_free(&arena);
+    printf("\n");
+}
+#endif
+
+// Tests that check exact block layout, which ARENA_DEBUG redzones change
+#ifdef ARENA_DEBUG
+#define LAYOUT_TEST(test) ((void)(test))
+#else
+#define LAYOUT_TEST(test) test()
+#endif
+
 int main(void) {
     printf("Arena Allocator Library Test Suite\n");
     
     test_basic_allocation();
     test_large_allocations();
     test_realloc();
+    LAYOUT_TEST(test_realloc_in_place);
+    test_free_lists();
     test_reset();
+    test_reset_policy();
+    test_object_pool();
+    LAYOUT_TEST(test_array_and_string);
+    test_hash_map();
+    test_intern();
     test_alignment();
+    LAYOUT_TEST(test_aligned_allocation);
+    LAYOUT_TEST(test_batch_allocation);
+    test_block_cursor();
+    LAYOUT_TEST(test_growth_policy);
+    LAYOUT_TEST(test_mark_rewind);
+    test_concurrent();
+    test_block_pool();
+    LAYOUT_TEST(test_virtual_reserve);
+    test_huge_pages();
+    test_backing_allocator();
+    test_calloc();
+    test_frame_arena();
+    test_failure_policy();
+    LAYOUT_TEST(test_numa);
+    LAYOUT_TEST(test_stats);
+    test_file_arena();
+    test_shared_arena();
+#ifdef ARENA_TRACE
+    test_trace();
+#endif
+#ifdef ARENA_DEBUG
+    test_debug_mode();
+#endif
     
     printf("All tests completed!\n");
     return 0;
@@ -0,0 +1,176 @@
+#include "arena.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Point {
+    double x;
+    double y;
+    Point(double x_, double y_) : x(x_), y(y_) {}
+};
+
+struct alignas(64) CacheLine {
+    char bytes[64];
+};
+
+static void test_memory_resource() {
+    printf("=== Testing pmr Memory Resource ===\n");
+    arena::Arena arena(4096);
+    arena::Resource resource(arena);
+
+    std::pmr::vector<int> values(&resource);
+    for (int i = 0; i < 10000; i++) {
+        values.push_back(i);
+    }
+    std::pmr::unordered_map<std::pmr::string, int> counts(&resource);
+    for (int i = 0; i < 1000; i++) {
+        counts[std::pmr::string("a fairly long key, past the SSO buffer ") + std::to_string(i % 100).c_str()]++;
+    }
+    assert(values.size() == 10000 && values[9999] == 9999);
+    assert(counts.size() == 100);
+    assert(counts.begin()->second == 10);
+    assert(counts.get_allocator().resource() == &resource);
+    assert(resource.is_equal(resource));
+
+    // Memory requested through the resource is the arena's
+    size_t used = arena_total_used(arena);
+    void *ptr = resource.allocate(64, 64);
+    assert((uintptr_t)ptr % 64 == 0);
+    assert(arena_total_used(arena) > used);
+    printf("10000 ints and 100 strings on %zu arena bytes\n", arena_total_used(arena));
+    printf("\n");
+}
+
+static void test_stl_allocator() {
+    printf("=== Testing STL Allocator ===\n");
+    arena::Arena arena(4096);
+
+    std::vector<Point, arena::Allocator<Point>> points{arena::Allocator<Point>(arena)};
+    for (int i = 0; i < 1000; i++) {
+        points.emplace_back(i, -i);
+    }
+    assert(points[999].y == -999);
+
+    using StringAlloc = arena::Allocator<char>;
+    using String = std::basic_string<char, std::char_traits<char>, StringAlloc>;
+    using MapAlloc = arena::Allocator<std::pair<const int, String>>;
+    std::unordered_map<int, String, std::hash<int>, std::equal_to<int>, MapAlloc> names{
+        MapAlloc(arena)};
+    for (int i = 0; i < 100; i++) {
+        names.emplace(i, String(64, (char)('a' + i % 26), StringAlloc(arena)));
+    }
+    assert(names.at(27) == String(64, 'b', StringAlloc(arena)));
+
+    // Rebound copies share the arena
+    arena::Allocator<double> doubles(points.get_allocator());
+    assert(doubles == points.get_allocator());
+    arena::Arena other(128);
+    assert(arena::Allocator<double>(other) != doubles);
+
+    std::vector<CacheLine, arena::Allocator<CacheLine>> lines{arena::Allocator<CacheLine>(arena)};
+    lines.resize(10);
+    assert((uintptr_t)lines.data() % 64 == 0);
+    printf("Vector, map of strings and over-aligned type in one arena\n");
+    printf("\n");
+}
+
+static void test_scope() {
+    printf("=== Testing Scope Guard ===\n");
+    arena::Arena arena(4096);
+    Point *kept = arena::create<Point>(arena, 1.0, 2.0);
+    size_t used = arena_total_used(arena);
+
+    {
+        arena::Scope scope(arena);
+        int *scratch = arena::create_array<int>(arena, 100000);
+        assert(scratch[99999] == 0);
+        std::vector<int, arena::Allocator<int>> temporary{arena::Allocator<int>(arena)};
+        temporary.assign(1000, 7);
+        assert(arena_total_used(arena) > used);
+    }
+    assert(arena_total_used(arena) == used);
+    assert(kept->x == 1.0 && kept->y == 2.0);
+    printf("Scope released everything allocated inside it\n");
+    printf("\n");
+}
+
+static void test_free_list_reuse() {
+    printf("=== Testing Free List Reuse ===\n");
+    ArenaConfig config = {};
+    config.free_lists = true;
+    arena::Arena arena(config);
+
+    // A buffer a container gives back is handed out again
+    arena::Allocator<int> ints(arena);
+    int *first = ints.allocate(64);
+    ints.allocate(1);
+    ints.deallocate(first, 64);
+    assert(ints.allocate(64) == first);
+
+    arena::Resource resource(arena);
+    void *chunk = resource.allocate(256, alignof(double));
+    void *pinned = resource.allocate(8, alignof(double));
+    (void)pinned;
+    resource.deallocate(chunk, 256, alignof(double));
+    assert(resource.allocate(256, alignof(double)) == chunk);
+
+    // Vectors growing by doubling recycle the buffers they moved away from
+    size_t used = arena_total_used(arena);
+    for (int round = 0; round < 10; round++) {
+        std::vector<int, arena::Allocator<int>> values{ints};
+        for (int i = 0; i < 1000; i++) {
+            values.push_back(i);
+        }
+        ints.allocate(1);
+    }
+    // Without reuse each round would take another 8KB of buffers
+    assert(arena_total_used(arena) - used < 4 * 8192);
+    printf("Released chunks reused, 10 vectors on %zu bytes\n", arena_total_used(arena) - used);
+    printf("\n");
+}
+
+static void test_allocation_failure() {
+    printf("=== Testing Allocation Failure ===\n");
+    ArenaConfig config = {};
+    config.reserve_size = (size_t)1 << 20;
+    config.failure_policy = ARENA_FAIL_NULL;
+    arena::Arena arena(config);
+
+    bool thrown = false;
+    try {
+        std::vector<char, arena::Allocator<char>> big{arena::Allocator<char>(arena)};
+        big.resize((size_t)2 << 20);
+    } catch (const std::bad_alloc &) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    arena::Resource resource(arena);
+    thrown = false;
+    try {
+        void *ptr = resource.allocate((size_t)2 << 20);
+        (void)ptr;
+    } catch (const std::bad_alloc &) {
+        thrown = true;
+    }
+    assert(thrown);
+    printf("Exhausted arena throws std::bad_alloc\n");
+    printf("\n");
+}
+
+int main() {
+    printf("Arena Allocator C++ Test Suite\n");
+    printf("==============================\n\n");
+
+    test_memory_resource();
+    test_stl_allocator();
+    test_scope();
+    test_free_list_reuse();
+    test_allocation_failure();
+
+    printf("All tests completed!\n");
+    return 0;
+}